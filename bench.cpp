@@ -0,0 +1,177 @@
+// Microbenchmarks de las funciones calientes (make bench).
+// Uso: bench [--filter TEXTO] [--out resultados.csv] [--label ETIQUETA] [--compare anterior.csv]
+// Cada benchmark se calibra para que una repeticion dure ~5 ms y se repite REPS veces;
+// se informa mediana, media, desviacion estandar y minimo en ns/op, y asignaciones/op
+// (compilado con FISICA_ALLOC_STATS). El CSV permite comparar entre commits.
+
+#define FISICA_NO_MAIN
+#include "main2.cpp"
+
+#include <chrono>
+#include <map>
+
+struct BenchResult {
+    std::string name;
+    double medianNs, meanNs, stddevNs, minNs;
+    double allocsPerOp, bytesPerOp;
+    int reps;
+    long long iters;
+};
+
+const int REPS = 15;
+const double TARGET_REP_NS = 5e6;
+
+volatile float g_benchSink; // Evita que el compilador elimine el trabajo medido
+
+template <typename F>
+double timeBatch(F& op, long long iters) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (long long i = 0; i < iters; ++i) op(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+}
+
+template <typename F>
+BenchResult runBench(const std::string& name, F op) {
+    // Calibracion (tambien sirve de calentamiento)
+    long long iters = 1;
+    while (iters < (1LL << 26)) {
+        if (timeBatch(op, iters) >= TARGET_REP_NS) break;
+        iters *= 2;
+    }
+
+    std::vector<double> samples;
+    AllocStats before = allocStatsNow();
+    for (int r = 0; r < REPS; ++r) samples.push_back(timeBatch(op, iters) / iters);
+    AllocStats allocs = allocStatsNow().since(before);
+
+    BenchResult res;
+    res.name = name;
+    res.reps = REPS;
+    res.iters = iters;
+
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    res.meanNs = sum / samples.size();
+    double sq = 0.0;
+    for (double v : samples) sq += (v - res.meanNs) * (v - res.meanNs);
+    res.stddevNs = std::sqrt(sq / (samples.size() - 1));
+    std::sort(samples.begin(), samples.end());
+    res.medianNs = samples[samples.size() / 2];
+    res.minNs = samples.front();
+
+    double ops = static_cast<double>(iters) * REPS;
+    res.allocsPerOp = allocs.totalCount() / ops;
+    res.bytesPerOp = allocs.totalBytes() / ops;
+    return res;
+}
+
+std::map<std::string, double> loadMedians(const std::string& path) {
+    std::map<std::string, double> medians;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line); // Cabecera
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string label, name, median;
+        if (std::getline(ss, label, ',') && std::getline(ss, name, ',') && std::getline(ss, median, ','))
+            medians[name] = std::atof(median.c_str());
+    }
+    return medians;
+}
+
+int main(int argc, char** argv) {
+    std::string filter, outPath, label = "local", comparePath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (arg == "--label" && i + 1 < argc) label = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc) comparePath = argv[++i];
+    }
+    if (!ALLOC_STATS_ENABLED) std::cerr << "Aviso: compilado sin FISICA_ALLOC_STATS, asignaciones/op = 0" << std::endl;
+
+    std::srand(1);
+
+    sf::RenderTexture offscreen;
+    if (!offscreen.create(1000, 700)) {
+        std::cerr << "Error: No se pudo crear el RenderTexture (contexto OpenGL)" << std::endl;
+        return -1;
+    }
+
+    BakedFont font;
+    if (!font.loadEmbedded()) {
+        std::cerr << "Error: No se pudo crear la textura de la fuente" << std::endl;
+        return -1;
+    }
+
+    LevelCatalogue catalogue; // Valores por defecto, sin leer niveles.cfg
+    Simulator simulator(font, catalogue.incline);
+    SeesawSimulator seesaw(font, catalogue.seesaw);
+    Block block(true, sf::Color::Yellow, font);
+    ForceArrowSet arrows(font, 1);
+    arrows.add("Peso (W1)", "m1 * g", sf::Color::Red);
+    Tooltip tooltip(font);
+    RenderStats renderStats;
+    CountingRenderTarget counted(offscreen, renderStats);
+
+    // Magnitudes cuantizadas, como las que produce un slider
+    const float mags[16] = {4.9f, 9.8f, 14.7f, 19.6f, 24.5f, 29.4f, 34.3f, 39.2f, 44.1f, 49.0f, 53.9f, 58.8f, 63.7f, 68.6f, 73.5f, 78.4f};
+
+    std::vector<BenchResult> results;
+    auto add = [&](const std::string& name, std::function<void(long long)> op) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+        results.push_back(runBench(name, op));
+        const BenchResult& r = results.back();
+        std::printf("%-36s %12.1f ns/op  +-%8.1f  min %10.1f  %7.2f allocs/op  %9.1f B/op\n",
+                    r.name.c_str(), r.medianNs, r.stddevNs, r.minNs, r.allocsPerOp, r.bytesPerOp);
+        std::fflush(stdout);
+    };
+
+    add("Simulator::calculatePhysics", [&](long long) { simulator.calculatePhysics(); });
+    add("Block::updatePhysics", [&](long long i) {
+        block.updatePhysics(mags[i & 15] / G, 30.f, 49.f, 10.f, (i & 1) != 0);
+    });
+    add("ForceArrowSet::update", [&](long long i) {
+        arrows.update(0, sf::Vector2f(400, 300), sf::Vector2f(0, 1), mags[i & 15], 2.f);
+        g_benchSink = arrows.getMagnitude(0);
+    });
+    add("ForceArrowSet::updateGeometry", [&](long long i) {
+        arrows.updateGeometry(0, sf::Vector2f(400, 300), sf::Vector2f(0, 1), mags[i & 15], 2.f);
+        g_benchSink = arrows.getMagnitude(0);
+    });
+    add("Block::handleHover", [&](long long i) {
+        block.handleHover(sf::Vector2f(380.f + (i & 63), 300.f));
+    });
+    add("Tooltip::show", [&](long long i) {
+        tooltip.show("Peso (W1)", "m1 * g", mags[i & 15], sf::Vector2f(300, 200));
+    });
+    add("SeesawSimulator::resetGame", [&](long long) { seesaw.resetGame(); });
+    add("SeesawSimulator::updateVisualState", [&](long long) { seesaw.updateVisualState(); });
+    add("SeesawSimulator::drawDashedLine", [&](long long) {
+        seesaw.drawDashedLine(counted, 500.f, 550.f, 200.f, 600.f, sf::Color::Black);
+    });
+    offscreen.display();
+
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        out << "label,name,median_ns,mean_ns,stddev_ns,min_ns,allocs_per_op,bytes_per_op,reps,iters\n";
+        for (const BenchResult& r : results) {
+            out << label << "," << r.name << "," << r.medianNs << "," << r.meanNs << "," << r.stddevNs << "," << r.minNs << ","
+                << r.allocsPerOp << "," << r.bytesPerOp << "," << r.reps << "," << r.iters << "\n";
+        }
+    }
+
+    if (!comparePath.empty()) {
+        std::map<std::string, double> old = loadMedians(comparePath);
+        std::printf("\nComparacion con %s (mediana):\n", comparePath.c_str());
+        for (const BenchResult& r : results) {
+            auto it = old.find(r.name);
+            if (it == old.end() || it->second <= 0.0) continue;
+            std::printf("%-36s %12.1f -> %12.1f ns/op  (%+.1f%%)\n", r.name.c_str(), it->second, r.medianNs,
+                        (r.medianNs - it->second) / it->second * 100.0);
+        }
+    }
+
+    return 0;
+}
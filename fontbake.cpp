@@ -0,0 +1,140 @@
+// Herramienta de compilacion: rasteriza con FreeType (via sf::Font) el conjunto de
+// glifos y tamaños que usa el juego y genera font_atlas.h con el atlas embebido.
+// Uso: fontbake <fuente.ttf> <salida.h>
+
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// Tamaños usados por ForceArrow, Tooltip, InputBox, Button, msgLabel y el titulo del menu
+const unsigned int SIZES[] = {12, 14, 16, 18, 20, 22, 40};
+
+const unsigned int ATLAS_WIDTH = 512;
+const unsigned int ATLAS_PADDING = 1;
+
+struct OutGlyph {
+    sf::Uint32 codepoint;
+    unsigned int size;
+    float advance;
+    sf::FloatRect bounds;
+    sf::IntRect rect;
+};
+
+std::vector<sf::Uint32> buildCharset() {
+    std::vector<sf::Uint32> cps;
+    for (sf::Uint32 c = 32; c < 127; ++c) cps.push_back(c);
+    const sf::Uint32 extra[] = {
+        0x00A1, 0x00BF, 0x00B0, 0x00B7,                 // ¡ ¿ ° ·
+        0x00E1, 0x00E9, 0x00ED, 0x00F3, 0x00FA, 0x00F1, // á é í ó ú ñ
+        0x00C1, 0x00C9, 0x00CD, 0x00D3, 0x00DA, 0x00D1, // Á É Í Ó Ú Ñ
+        0x03B8, 0x03BC                                  // θ μ
+    };
+    cps.insert(cps.end(), std::begin(extra), std::end(extra));
+    return cps;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Uso: fontbake <fuente.ttf> <salida.h>" << std::endl;
+        return 1;
+    }
+
+    sf::Font font;
+    if (!font.loadFromFile(argv[1])) {
+        std::cerr << "Error: No se pudo cargar " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<sf::Uint32> charset = buildCharset();
+    std::vector<OutGlyph> glyphs;
+    std::vector<float> lineSpacings;
+    std::vector<sf::Uint8> atlas;
+    unsigned int atlasHeight = 0;
+
+    // Empaquetado por estantes
+    unsigned int penX = 0, penY = 0, shelfHeight = 0;
+
+    for (unsigned int size : SIZES) {
+        for (sf::Uint32 cp : charset) font.getGlyph(cp, size, false);
+        sf::Image page = font.getTexture(size).copyToImage();
+        lineSpacings.push_back(font.getLineSpacing(size));
+
+        for (sf::Uint32 cp : charset) {
+            const sf::Glyph& g = font.getGlyph(cp, size, false);
+
+            // Se copia un pixel extra alrededor del glifo, igual que hace sf::Text al dibujar
+            sf::IntRect src(g.textureRect.left - 1, g.textureRect.top - 1, g.textureRect.width + 2, g.textureRect.height + 2);
+            if (g.textureRect.width == 0 || g.textureRect.height == 0) src = sf::IntRect(0, 0, 0, 0);
+
+            if (penX + src.width + ATLAS_PADDING > ATLAS_WIDTH) {
+                penX = 0;
+                penY += shelfHeight + ATLAS_PADDING;
+                shelfHeight = 0;
+            }
+
+            OutGlyph out;
+            out.codepoint = cp;
+            out.size = size;
+            out.advance = g.advance;
+            out.bounds = (src.width > 0) ? sf::FloatRect(g.bounds.left - 1, g.bounds.top - 1, g.bounds.width + 2, g.bounds.height + 2) : sf::FloatRect();
+            out.rect = sf::IntRect(penX, penY, src.width, src.height);
+            glyphs.push_back(out);
+
+            unsigned int needed = penY + src.height;
+            if (needed > atlasHeight) {
+                atlasHeight = needed;
+                atlas.resize(ATLAS_WIDTH * atlasHeight, 0);
+            }
+            for (int y = 0; y < src.height; ++y) {
+                for (int x = 0; x < src.width; ++x) {
+                    sf::Color px = page.getPixel(src.left + x, src.top + y);
+                    atlas[(penY + y) * ATLAS_WIDTH + penX + x] = px.a;
+                }
+            }
+
+            penX += src.width + ATLAS_PADDING;
+            shelfHeight = std::max(shelfHeight, static_cast<unsigned int>(src.height));
+        }
+    }
+
+    std::ofstream out(argv[2]);
+    if (!out) {
+        std::cerr << "Error: No se pudo escribir " << argv[2] << std::endl;
+        return 1;
+    }
+    out << std::showpoint; // Los literales float necesitan punto decimal
+
+    out << "// Generado por fontbake a partir de " << argv[1] << ". No editar.\n";
+    out << "#pragma once\n\n";
+    out << "struct BakedSizeEntry { unsigned int size; float lineSpacing; };\n";
+    out << "struct BakedGlyphEntry { unsigned int codepoint; unsigned int size; float advance;\n";
+    out << "    float left, top, width, height; int u, v, w, h; };\n\n";
+    out << "const unsigned int FONT_ATLAS_WIDTH = " << ATLAS_WIDTH << ";\n";
+    out << "const unsigned int FONT_ATLAS_HEIGHT = " << atlasHeight << ";\n\n";
+
+    out << "const BakedSizeEntry FONT_ATLAS_SIZES[] = {\n";
+    for (std::size_t i = 0; i < lineSpacings.size(); ++i)
+        out << "    {" << SIZES[i] << ", " << lineSpacings[i] << "f},\n";
+    out << "};\n\n";
+
+    out << "const BakedGlyphEntry FONT_ATLAS_GLYPHS[] = {\n";
+    for (const OutGlyph& g : glyphs) {
+        out << "    {" << g.codepoint << ", " << g.size << ", " << g.advance << "f, "
+            << g.bounds.left << "f, " << g.bounds.top << "f, " << g.bounds.width << "f, " << g.bounds.height << "f, "
+            << g.rect.left << ", " << g.rect.top << ", " << g.rect.width << ", " << g.rect.height << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "const unsigned char FONT_ATLAS_ALPHA[] = {";
+    for (std::size_t i = 0; i < atlas.size(); ++i) {
+        if (i % 24 == 0) out << "\n    ";
+        out << static_cast<unsigned int>(atlas[i]) << ",";
+    }
+    out << "\n};\n";
+
+    std::cout << "Atlas " << ATLAS_WIDTH << "x" << atlasHeight << ", " << glyphs.size() << " glifos" << std::endl;
+    return 0;
+}
@@ -2,6 +2,7 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
+#include <SFML/OpenGL.hpp>
 #include <iostream>
 #include <vector>
 #include <cmath>
@@ -12,6 +13,38 @@
 #include <ctime>
 #include <cstdlib>
 #include <algorithm>
+#include <unordered_map>
+#include <list>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <charconv>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+#include <memory>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+#ifdef FISICA_TRACE
+#include <chrono>
+#include <mutex>
+#endif
+
+#include "font_atlas.h" // Generado por fontbake (ver makefile)
 
 const float G = 9.8f;
 const float PI = 3.14159265359f;
@@ -19,1243 +52,5081 @@ const float EPSILON = 0.5f; // Tolerancia para equilibrio
 
 float toRad(float deg) { return deg * PI / 180.f; }
 
-// ----------------- UI / Utility (Clases originales) -----------------
-// ... (Tooltip, ForceArrow, InputBox, Button, Slider - sin cambios relevantes en estas clases)
-// ... (Las definiciones de estas clases se mantienen igual que en el código anterior)
+#define FISICA_CONCAT_INNER(a, b) a##b
+#define FISICA_CONCAT(a, b) FISICA_CONCAT_INNER(a, b)
+
+// ----------------- Trazas (formato Chrome trace / Perfetto) -----------------
+// TRACE_SCOPE("nombre") registra el intervalo del ambito actual. Solo existe si se compila
+// con -DFISICA_TRACE (make trace); sin esa bandera la macro no genera codigo.
+// Cada hilo escribe en su propio buffer circular sin bloqueos; el registro de hilos
+// (una vez por hilo) y el volcado a JSON son las unicas partes con mutex.
+#ifdef FISICA_TRACE
+struct TraceEvent {
+    const char* name;
+    long long beginUs;
+    long long durationUs;
+};
 
-// ForceArrow (Mantengo la clase completa para referencia, aunque el cuerpo es el mismo)
-class Tooltip {
-// ... (Contenido de Tooltip)
-private:
-    sf::RectangleShape background;
-    sf::Text textInfo;
-    bool visible;
+class TraceBuffer {
 public:
-    Tooltip(sf::Font& font) {
-        background.setFillColor(sf::Color(50, 50, 50, 230));
-        background.setOutlineColor(sf::Color::White);
-        background.setOutlineThickness(1);
+    static const std::size_t CAPACITY = 1 << 16; // Se conservan los eventos mas recientes
 
-        textInfo.setFont(font);
-        textInfo.setCharacterSize(14);
-        textInfo.setFillColor(sf::Color::White);
-        visible = false;
+    TraceEvent events[CAPACITY];
+    std::atomic<std::size_t> count;
+    unsigned int threadId;
+
+    explicit TraceBuffer(unsigned int tid) : count(0), threadId(tid) {}
+
+    void push(const char* name, long long beginUs, long long durationUs) {
+        std::size_t n = count.load(std::memory_order_relaxed);
+        events[n % CAPACITY] = TraceEvent{name, beginUs, durationUs};
+        count.store(n + 1, std::memory_order_release);
     }
+};
 
-    void show(std::string name, std::string formula, float value, sf::Vector2f pos, std::string extra = "") {
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(2);
-        
-        if (extra == "Seesaw") { 
-            ss << "Momento: " << name << "\n";
-            ss << "Formula: " << formula << "\n";
-            ss << "Valor: " << value << " N*cm"; 
-        } else { 
-            ss << "Fuerza: " << name << "\n";
-            ss << "Formula: " << formula << "\n";
-            ss << "Valor: " << value << " N";
-            if (!extra.empty()) ss << "\n(" << extra << ")";
-        }
-        
+class TraceRecorder {
+private:
+    std::mutex registryMutex;
+    std::vector<TraceBuffer*> buffers;
+    std::chrono::steady_clock::time_point origin;
 
-        textInfo.setString(ss.str());
-        sf::FloatRect bounds = textInfo.getGlobalBounds();
-        background.setSize(sf::Vector2f(bounds.width + 20, bounds.height + 20));
-        background.setPosition(pos);
-        textInfo.setPosition(pos.x + 10, pos.y + 10);
-        visible = true;
+    TraceRecorder() : origin(std::chrono::steady_clock::now()) {}
+
+public:
+    static TraceRecorder& instance() {
+        static TraceRecorder recorder;
+        return recorder;
     }
 
-    void hide() { visible = false; }
-    bool isVisible() const { return visible; }
+    long long nowUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    TraceBuffer& threadBuffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer = new TraceBuffer(static_cast<unsigned int>(buffers.size() + 1));
+            buffers.push_back(buffer); // Vive hasta el final del proceso para poder volcarlo
+        }
+        return *buffer;
+    }
 
-    void draw(sf::RenderWindow& window) {
-        if (visible) { window.draw(background); window.draw(textInfo); }
+    bool writeJson(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        std::vector<TraceEvent> copy;
+        for (TraceBuffer* b : buffers) {
+            // Otro hilo puede seguir escribiendo en su buffer: se copia y despues se descartan
+            // los eventos cuyo hueco pudo reescribirse mientras tanto (incluido el que esta en curso)
+            std::size_t n = b->count.load(std::memory_order_acquire);
+            std::size_t start = (n > TraceBuffer::CAPACITY) ? n - TraceBuffer::CAPACITY : 0;
+            copy.clear();
+            for (std::size_t i = start; i < n; ++i) copy.push_back(b->events[i % TraceBuffer::CAPACITY]);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::size_t after = b->count.load(std::memory_order_relaxed);
+            std::size_t valid = (after + 1 > TraceBuffer::CAPACITY) ? after + 1 - TraceBuffer::CAPACITY : 0;
+            for (std::size_t i = std::max(start, valid); i < n; ++i) {
+                const TraceEvent& e = copy[i - start];
+                out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << e.beginUs
+                    << ",\"dur\":" << e.durationUs << ",\"pid\":1,\"tid\":" << b->threadId << "}";
+                first = false;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return true;
     }
 };
 
-class ForceArrow {
+class TraceScope {
 private:
-    sf::RectangleShape line;
-    sf::ConvexShape triangle;
-    sf::Text label;
-    std::string name;
-    std::string formula;
-    std::string extraDesc;
-    float magnitude;
-    bool isHovered;
-    sf::Color baseColor;
+    const char* name;
+    long long beginUs;
 public:
-    ForceArrow(std::string n, std::string form, sf::Color c, sf::Font& font, std::string extra = "")
-        : name(n), formula(form), baseColor(c), extraDesc(extra), isHovered(false), magnitude(0.0f) {
-        triangle.setPointCount(3);
-        label.setFont(font);
-        label.setCharacterSize(12);
-        label.setFillColor(sf::Color::Black);
-        line.setFillColor(baseColor);
-        triangle.setFillColor(baseColor);
+    explicit TraceScope(const char* n) : name(n), beginUs(TraceRecorder::instance().nowUs()) {}
+    ~TraceScope() {
+        TraceRecorder& rec = TraceRecorder::instance();
+        rec.threadBuffer().push(name, beginUs, rec.nowUs() - beginUs);
     }
+};
 
-    void update(sf::Vector2f start, sf::Vector2f direction, float magValue, float scale) {
-        magnitude = magValue;
+#define TRACE_SCOPE(name) TraceScope FISICA_CONCAT(traceScope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
 
-        if (magValue < 0.05f) {
-            line.setSize(sf::Vector2f(0, 0));
-            triangle.setPosition(start);
-            label.setString("");
-            return;
+// ----------------- Conteo de asignaciones de memoria -----------------
+// Con -DFISICA_ALLOC_STATS (make allocstats) se reemplaza el operator new global para contar
+// asignaciones y bytes, atribuidos al subsistema marcado con ALLOC_SCOPE en el hilo actual.
+// Sin la bandera ALLOC_SCOPE no genera codigo y allocStatsNow() devuelve ceros.
+enum class AllocSubsystem { Other, Events, Update, Draw, TextLayout, Count };
+
+const int ALLOC_SUBSYSTEMS = static_cast<int>(AllocSubsystem::Count);
+
+struct AllocStats {
+    unsigned long long count[ALLOC_SUBSYSTEMS];
+    unsigned long long bytes[ALLOC_SUBSYSTEMS];
+
+    unsigned long long totalCount() const {
+        unsigned long long t = 0;
+        for (int i = 0; i < ALLOC_SUBSYSTEMS; ++i) t += count[i];
+        return t;
+    }
+    unsigned long long totalBytes() const {
+        unsigned long long t = 0;
+        for (int i = 0; i < ALLOC_SUBSYSTEMS; ++i) t += bytes[i];
+        return t;
+    }
+    // Diferencia respecto a una instantanea anterior
+    AllocStats since(const AllocStats& before) const {
+        AllocStats d;
+        for (int i = 0; i < ALLOC_SUBSYSTEMS; ++i) {
+            d.count[i] = count[i] - before.count[i];
+            d.bytes[i] = bytes[i] - before.bytes[i];
         }
+        return d;
+    }
+};
 
-        float dirLen = std::sqrt(direction.x*direction.x + direction.y*direction.y);
-        sf::Vector2f dirUnit = (dirLen > 0.0001f) ? (direction / dirLen) : sf::Vector2f(1,0);
+const char* allocSubsystemName(int index) {
+    static const char* names[ALLOC_SUBSYSTEMS] = {"otros", "eventos", "update", "draw", "texto"};
+    return names[index];
+}
 
-        float vizLength = std::min(std::max(magValue * scale, 30.f), 160.f);
+#ifdef FISICA_ALLOC_STATS
+const bool ALLOC_STATS_ENABLED = true;
+
+// Atomicos con inicializacion constante: validos antes de cualquier constructor estatico
+std::atomic<unsigned long long> g_allocCount[ALLOC_SUBSYSTEMS];
+std::atomic<unsigned long long> g_allocBytes[ALLOC_SUBSYSTEMS];
+thread_local AllocSubsystem g_allocSubsystem = AllocSubsystem::Other;
+
+void* operator new(std::size_t size) {
+    int sub = static_cast<int>(g_allocSubsystem);
+    g_allocCount[sub].fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes[sub].fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+AllocStats allocStatsNow() {
+    AllocStats s;
+    for (int i = 0; i < ALLOC_SUBSYSTEMS; ++i) {
+        s.count[i] = g_allocCount[i].load(std::memory_order_relaxed);
+        s.bytes[i] = g_allocBytes[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
 
-        line.setSize(sf::Vector2f(vizLength, 4));
-        line.setOrigin(0, 2);
-        line.setPosition(start);
+class AllocScope {
+private:
+    AllocSubsystem previous;
+public:
+    explicit AllocScope(AllocSubsystem sub) : previous(g_allocSubsystem) { g_allocSubsystem = sub; }
+    ~AllocScope() { g_allocSubsystem = previous; }
+};
 
-        float angle = std::atan2(dirUnit.y, dirUnit.x) * 180.f / PI;
-        line.setRotation(angle);
+#define ALLOC_SCOPE(sub) AllocScope FISICA_CONCAT(allocScope_, __LINE__)(sub)
+#else
+const bool ALLOC_STATS_ENABLED = false;
 
-        triangle.setPoint(0, sf::Vector2f(0, 0));
-        triangle.setPoint(1, sf::Vector2f(-10, -6));
-        triangle.setPoint(2, sf::Vector2f(-10, 6));
-        triangle.setPosition(start + dirUnit * vizLength);
-        triangle.setRotation(angle);
+AllocStats allocStatsNow() { return AllocStats(); }
 
-        sf::Color drawColor = isHovered ? sf::Color(std::min(baseColor.r + 100, 255), std::min(baseColor.g + 100, 255), std::min(baseColor.b + 100, 255)) : baseColor;
-        line.setFillColor(drawColor);
-        triangle.setFillColor(drawColor);
+#define ALLOC_SCOPE(sub) ((void)0)
+#endif
 
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(1) << magValue << " N";
-        label.setString(ss.str());
-        label.setPosition(triangle.getPosition() + sf::Vector2f(10, 8));
-    }
+// ----------------- Latencia entrada -> pantalla -----------------
+// Cada evento se marca al salir de pollEvent (beginEvent). Si su manejo produce un cambio
+// visible (knob del slider, texto de un InputBox, tooltip) el cambio queda pendiente con la
+// marca del evento hasta el window.display() que lo muestra (displayed), y ahi se registra
+// la latencia. SFML no da la marca de tiempo del sistema operativo, asi que no se mide lo
+// que el evento espera en la cola antes de pollEvent.
+enum class LatencyKind { Slider, Text, Tooltip, Count };
 
-    bool checkHover(sf::Vector2f mousePos) {
-        sf::FloatRect bounds = line.getGlobalBounds();
-        bounds.width += 12; bounds.height += 12;
-        bounds.left -= 6; bounds.top -= 6;
-        isHovered = bounds.contains(mousePos);
-        return isHovered;
-    }
+const int LATENCY_KINDS = static_cast<int>(LatencyKind::Count);
 
-    void handleClick(sf::Vector2f mousePos, Tooltip& tooltip, std::string extra = "") {
-        if (isHovered) tooltip.show(name, formula, magnitude, mousePos, extra);
-    }
+const char* latencyKindName(int index) {
+    static const char* names[LATENCY_KINDS] = {"Slider", "Texto", "Tooltip"};
+    return names[index];
+}
 
-    void draw(sf::RenderWindow& window) {
-        if (magnitude > 0.05f) {
-            window.draw(line);
-            window.draw(triangle);
-            window.draw(label);
-        }
-    }
-    
-    float getMagnitude() const { return magnitude; }
-    std::string getName() const { return name; }
-    std::string getFormula() const { return formula; }
+struct LatencySummary {
+    int count;
+    float p50, p95, p99, worst; // Microsegundos
 };
 
-class InputBox {
-// ... (Contenido de InputBox)
+class LatencyTracker {
 private:
-    sf::RectangleShape box;
-    sf::Text text;
-    std::string currentString;
-    bool hasFocus;
-    float width, height;
+    static const int MAX_PENDING = 64;
+    static const int HISTORY = 512;
+
+    struct Pending { LatencyKind kind; sf::Int64 polledUs; };
+
+    sf::Clock clock;
+    sf::Int64 currentEvent; // -1 fuera del manejo de un evento
+    Pending pending[MAX_PENDING];
+    int pendingCount;
+    float samples[LATENCY_KINDS][HISTORY];
+    int head[LATENCY_KINDS];
+    int filled[LATENCY_KINDS];
+    float frameWorst;
+
+    LatencyTracker() : currentEvent(-1), pendingCount(0), frameWorst(0.f) {
+        for (int k = 0; k < LATENCY_KINDS; ++k) { head[k] = 0; filled[k] = 0; }
+    }
+
 public:
-    InputBox(float x, float y, float w, float h, sf::Font& font) : width(w), height(h), hasFocus(false), currentString("") {
-        box.setPosition(x, y);
-        box.setSize(sf::Vector2f(w, h));
-        box.setFillColor(sf::Color::White);
-        box.setOutlineColor(sf::Color(100, 100, 100));
-        box.setOutlineThickness(2);
+    static LatencyTracker& instance() {
+        static LatencyTracker tracker;
+        return tracker;
+    }
 
-        text.setFont(font);
-        text.setCharacterSize(18);
-        text.setFillColor(sf::Color::Black);
-        text.setPosition(x + 5, y + 5);
+    sf::Int64 now() const { return clock.getElapsedTime().asMicroseconds(); }
+
+    void beginEvent() { currentEvent = now(); }
+    // Para eventos agrupados: la latencia se mide desde el primero que se agrupo
+    void beginEvent(sf::Int64 polledUs) { currentEvent = (polledUs >= 0) ? polledUs : now(); }
+    void endEvent() { currentEvent = -1; }
+
+    // Lo llaman los widgets cuando un evento cambia algo que se ve
+    void noteChange(LatencyKind kind) {
+        if (currentEvent < 0) return;
+        for (int i = 0; i < pendingCount; ++i)
+            if (pending[i].kind == kind && pending[i].polledUs == currentEvent) return;
+        if (pendingCount < MAX_PENDING) pending[pendingCount++] = Pending{kind, currentEvent};
     }
 
-    void handleEvent(sf::Event event) {
-        if (!hasFocus) return;
-        if (event.type == sf::Event::TextEntered) {
-            if (event.text.unicode == 8) {
-                if (!currentString.empty()) currentString.pop_back();
-            } else if ((event.text.unicode >= '0' && event.text.unicode <= '9') || event.text.unicode == '.') {
-                if (event.text.unicode == '.' && currentString.find('.') != std::string::npos) return;
-                
-                if (currentString.length() < 8) currentString += static_cast<char>(event.text.unicode);
-            }
-            text.setString(currentString);
+    // Llamar justo despues de display(): los cambios pendientes ya estan en pantalla
+    void displayed() { displayed(now()); }
+
+    // Con --sim-thread el display lo hace otro hilo, que pasa su marca de tiempo
+    void displayed(sf::Int64 displayedUs) {
+        frameWorst = 0.f;
+        for (int i = 0; i < pendingCount; ++i) {
+            int k = static_cast<int>(pending[i].kind);
+            float latency = static_cast<float>(displayedUs - pending[i].polledUs);
+            samples[k][head[k]] = latency;
+            head[k] = (head[k] + 1) % HISTORY;
+            filled[k] = std::min(filled[k] + 1, HISTORY);
+            frameWorst = std::max(frameWorst, latency);
         }
+        pendingCount = 0;
     }
 
-    void checkClick(sf::Vector2f mousePos) {
-        if (box.getGlobalBounds().contains(mousePos)) { hasFocus = true; box.setOutlineColor(sf::Color::Blue); }
-        else { hasFocus = false; box.setOutlineColor(sf::Color(100,100,100)); }
+    // Peor latencia mostrada en el ultimo display (0 si no se mostro ningun cambio)
+    float getFrameWorst() const { return frameWorst; }
+
+    LatencySummary summarize(LatencyKind kind) const {
+        int k = static_cast<int>(kind);
+        LatencySummary s = {filled[k], 0.f, 0.f, 0.f, 0.f};
+        if (filled[k] == 0) return s;
+        std::vector<float> v(samples[k], samples[k] + filled[k]);
+        std::sort(v.begin(), v.end());
+        s.p50 = v[static_cast<std::size_t>(0.50f * (v.size() - 1))];
+        s.p95 = v[static_cast<std::size_t>(0.95f * (v.size() - 1))];
+        s.p99 = v[static_cast<std::size_t>(0.99f * (v.size() - 1))];
+        s.worst = v.back();
+        return s;
     }
 
-    float getValue() const {
-        if (currentString.empty()) return 0.0f;
-        try { return std::stof(currentString); } catch (...) { return 0.0f; }
+    void printSummary(std::ostream& out) const {
+        for (int k = 0; k < LATENCY_KINDS; ++k) {
+            LatencySummary s = summarize(static_cast<LatencyKind>(k));
+            if (s.count == 0) continue;
+            out << "Latencia " << latencyKindName(k) << ": " << s.count << " muestras, p50 " << s.p50 << " us, p95 "
+                << s.p95 << " us, p99 " << s.p99 << " us, peor " << s.worst << " us" << std::endl;
+        }
     }
+};
 
-    void clear() { currentString = ""; text.setString(""); }
+// ----------------- Arranque por fases -----------------
+// main() llama a begin() al entrar; cada fase del arranque (ventana, fuente, niveles, menu...)
+// hace mark() al terminar y se le atribuye el tiempo desde la marca anterior. finish() se
+// llama tras el primer display() y fija el tiempo hasta el primer frame. Fuera de ese
+// intervalo mark() no hace nada (bench y headless construyen niveles sin arranque).
+// No incluye lo anterior a main(): carga del ejecutable e inicializacion estatica.
+class StartupProfile {
+private:
+    static const int MAX_PHASES = 16;
 
-    void setString(const std::string &s) { 
-        currentString = s; 
-        text.setString(currentString); 
-        hasFocus = false; 
-        box.setOutlineColor(sf::Color(100,100,100));
-    }
+    struct Phase { const char* name; sf::Int64 us; };
 
-    void draw(sf::RenderWindow& window) { window.draw(box); window.draw(text); }
-};
+    sf::Clock clock;
+    sf::Int64 last;
+    Phase phases[MAX_PHASES];
+    int count;
+    bool active;
+    sf::Int64 firstFrameUs;
 
-class Button {
-// ... (Contenido de Button)
-private:
-    sf::RectangleShape shape;
-    sf::Text text;
-    sf::Color baseColor;
-public:
-    Button(float x, float y, float w, float h, std::string label, sf::Font& font, sf::Color color) 
-        : baseColor(color) {
-        shape.setPosition(x, y);
-        shape.setSize(sf::Vector2f(w, h));
-        shape.setFillColor(color);
+    StartupProfile() : last(0), count(0), active(false), firstFrameUs(-1) {}
 
-        text.setFont(font);
-        text.setString(label);
-        text.setCharacterSize(16);
-        text.setFillColor(sf::Color::White);
+public:
+    static StartupProfile& instance() {
+        static StartupProfile profile;
+        return profile;
+    }
 
-        sf::FloatRect textRect = text.getLocalBounds();
-        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top + textRect.height/2.0f);
-        text.setPosition(x + w/2.0f, y + h/2.0f);
+    void begin() {
+        clock.restart();
+        last = 0;
+        count = 0;
+        active = true;
+        firstFrameUs = -1;
     }
-    
-    void setFillColor(sf::Color color) { 
-        baseColor = color; 
-        shape.setFillColor(color); 
+
+    void mark(const char* name) {
+        if (!active) return;
+        sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+        if (count < MAX_PHASES) phases[count++] = Phase{name, now - last};
+        last = now;
     }
-    
-    const sf::Color& getFillColor() const { return baseColor; }
 
-    bool isClicked(sf::Vector2f mousePos) const {
-        return shape.getGlobalBounds().contains(mousePos);
+    void finish() {
+        if (!active) return;
+        firstFrameUs = clock.getElapsedTime().asMicroseconds();
+        active = false;
     }
 
-    void draw(sf::RenderWindow& window) const {
-        window.draw(shape);
-        window.draw(text);
+    bool isActive() const { return active; }
+    sf::Int64 getTimeToFirstFrame() const { return firstFrameUs; }
+
+    void print(std::ostream& out) const {
+        out << "Arranque:" << std::endl;
+        for (int i = 0; i < count; ++i)
+            out << "  " << std::left << std::setw(28) << phases[i].name << std::right << std::setw(10) << phases[i].us << " us" << std::endl;
+        out << "  Tiempo hasta el primer frame: " << std::fixed << std::setprecision(1) << firstFrameUs / 1000.0 << " ms" << std::endl;
     }
 };
 
-class Slider {
-// ... (Contenido de Slider)
+// ----------------- Memoria por propietario -----------------
+// Cada propietario de recursos (fuente, niveles, caches, lotes de vertices, render textures)
+// declara lo que tiene reservado a partir de sus propios contadores: tamaño de sus objetos,
+// vertices y cadenas que posee y bytes de textura/buffer en GPU. Es una cota del uso propio,
+// no incluye la sobrecarga del allocator ni la memoria interna de SFML/OpenGL.
+class MemoryReport {
 private:
-    sf::RectangleShape bar;
-    sf::CircleShape knob;
-    float minVal, maxVal;
-    float current;
-    bool dragging;
-    std::function<void(float)> valueChangedCallback; 
+    struct Entry {
+        std::string group;
+        std::string owner;
+        std::size_t bytes;
+        std::size_t objects;
+    };
+    std::vector<Entry> entries;
 
 public:
-    Slider(float x, float y, float w, float minV, float maxV, float initial = 0.0f, std::function<void(float)> callback = nullptr) 
-        : minVal(minV), maxVal(maxV), current(initial), dragging(false), valueChangedCallback(callback) {
-        
-        bar.setPosition(x, y);
-        bar.setSize(sf::Vector2f(w, 6));
-        bar.setFillColor(sf::Color(180,180,180));
+    void add(const std::string& group, const std::string& owner, std::size_t bytes, std::size_t objects = 1) {
+        for (Entry& e : entries) {
+            if (e.group == group && e.owner == owner) { e.bytes += bytes; e.objects += objects; return; }
+        }
+        entries.push_back(Entry{group, owner, bytes, objects});
+    }
 
-        knob.setRadius(9);
-        knob.setOrigin(9, 9);
-        knob.setFillColor(sf::Color(120,120,255));
-        
-        float t = (initial - minVal) / (maxVal - minVal);
-        float kx = x + std::max(0.f, std::min(t * w, w));
-        knob.setPosition(kx, y + 3);
+    std::size_t total() const {
+        std::size_t t = 0;
+        for (const Entry& e : entries) t += e.bytes;
+        return t;
+    }
 
-        if (valueChangedCallback) {
-            valueChangedCallback(current);
+    // Subtotales por grupo en el orden en que aparecieron
+    std::vector<std::pair<std::string, std::size_t>> groupTotals() const {
+        std::vector<std::pair<std::string, std::size_t>> totals;
+        for (const Entry& e : entries) {
+            auto it = std::find_if(totals.begin(), totals.end(), [&](const std::pair<std::string, std::size_t>& t) { return t.first == e.group; });
+            if (it == totals.end()) totals.push_back(std::make_pair(e.group, e.bytes));
+            else it->second += e.bytes;
         }
+        return totals;
     }
 
-    void handleEvent(const sf::Event& e, sf::Vector2f mouse) {
-        if (e.type == sf::Event::MouseButtonPressed) {
-            if (knob.getGlobalBounds().contains(mouse)) dragging = true;
-        } else if (e.type == sf::Event::MouseButtonReleased) {
-            dragging = false;
-        }
-        if (dragging && (e.type == sf::Event::MouseMoved || e.type == sf::Event::MouseButtonPressed)) {
-            float x = bar.getPosition().x;
-            float w = bar.getSize().x;
-            float newX = std::max(x, std::min(mouse.x, x + w));
-            knob.setPosition(newX, knob.getPosition().y);
-            float t = (newX - x) / w;
-            
-            float old_current = current; 
-            current = minVal + t * (maxVal - minVal);
-            
-            if (current != old_current && valueChangedCallback) {
-                valueChangedCallback(current); 
+    void print(std::ostream& out) const {
+        out << "Memoria por propietario:" << std::endl;
+        for (const auto& g : groupTotals()) {
+            out << "  " << g.first << ": " << g.second / 1024.0 << " KB" << std::endl;
+            for (const Entry& e : entries) {
+                if (e.group != g.first) continue;
+                out << "    " << std::left << std::setw(36) << e.owner << std::right << std::setw(10) << e.bytes << " B";
+                if (e.objects > 1) out << "  (" << e.objects << " objetos)";
+                out << std::endl;
             }
         }
+        out << "  Total: " << total() / 1024.0 << " KB" << std::endl;
     }
+};
 
-    float getValue() const { return current; }
+// ----------------- Arena por nivel -----------------
+// Cada nivel (y el menu) construye sus widgets, bloques, flechas y tooltip dentro de una
+// arena: bloques contiguos reservados de una vez. Delante de cada objeto va un nodo con su
+// destructor; al destruir la arena se destruyen en orden inverso y se libera todo de golpe,
+// sin delete a mano. Si la capacidad se queda corta se encadena otro bloque.
+class LevelArena {
+private:
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        std::size_t capacity;
+        std::size_t used;
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+    struct Node {
+        Node* prev;
+        void (*destroy)(void*);
+    };
+
+    Chunk* chunks;
+    Node* last;
+    std::size_t chunkSize;
+    std::size_t objectCount;
+
+    // Desplazamiento dentro del bloque en el que cabe un nodo seguido de un objeto alineado
+    static std::size_t objectOffset(Chunk* c, std::size_t used, std::size_t align) {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(c->data());
+        std::uintptr_t p = (base + used + sizeof(Node) + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+        return static_cast<std::size_t>(p - base);
+    }
 
-    void setValue(float v) {
-        current = std::max(minVal, std::min(v, maxVal));
-        float t = (current - minVal) / (maxVal - minVal);
-        float x = bar.getPosition().x;
-        float w = bar.getSize().x;
-        float kx = x + t * w;
-        knob.setPosition(kx, knob.getPosition().y);
-        
-        if (valueChangedCallback) {
-            valueChangedCallback(current);
+    Chunk* newChunk(std::size_t capacity) {
+        Chunk* c = static_cast<Chunk*>(::operator new(sizeof(Chunk) + capacity));
+        c->next = chunks;
+        c->capacity = capacity;
+        c->used = 0;
+        chunks = c;
+        return c;
+    }
+
+    // Reserva un nodo y el objeto que le sigue; devuelve la direccion del objeto
+    void* allocate(std::size_t size, std::size_t align) {
+        align = std::max(align, alignof(Node));
+        Chunk* c = chunks;
+        std::size_t offset = c ? objectOffset(c, c->used, align) : 0;
+        if (!c || offset + size > c->capacity) {
+            c = newChunk(std::max(chunkSize, size + sizeof(Node) + align));
+            offset = objectOffset(c, 0, align);
         }
+        c->used = offset + size;
+        return c->data() + offset;
     }
 
-    void draw(sf::RenderWindow& window) {
-        window.draw(bar);
-        window.draw(knob);
+    // Solo con el objeto ya construido: si el constructor lanza, el destructor no lo vera
+    void link(void* object, void (*destroy)(void*)) {
+        Node* node = reinterpret_cast<Node*>(static_cast<char*>(object) - sizeof(Node));
+        node->prev = last;
+        node->destroy = destroy;
+        last = node;
+        ++objectCount;
     }
-};
 
+    template <typename T>
+    static void destroyObject(void* p) { static_cast<T*>(p)->~T(); }
 
-// ----------------- Física / Objetos (Clases originales) -----------------
-class Block {
-// ... (Contenido de Block)
 public:
-    sf::RectangleShape shape;
-    std::vector<ForceArrow*> arrows;
-    float mass;
-    bool isOnSlope;
-
-    Block(bool slope, sf::Color color, sf::Font& font) : isOnSlope(slope), mass(0) {
-        shape.setSize(sf::Vector2f(50, 50));
-        shape.setOrigin(25, 25);
-        shape.setFillColor(color);
-        shape.setOutlineColor(sf::Color::Black);
-        shape.setOutlineThickness(2);
+    explicit LevelArena(std::size_t bytes) : chunks(nullptr), last(nullptr), chunkSize(bytes), objectCount(0) {
+        newChunk(chunkSize);
+    }
 
-        if (isOnSlope) {
-            arrows.push_back(new ForceArrow("Peso (W1)", "m1 * g", sf::Color::Red, font));
-            arrows.push_back(new ForceArrow("Normal (N1)", "W1 * cos(\u03B8)", sf::Color::Blue, font));
-            arrows.push_back(new ForceArrow("W Paralela", "W1 * sin(\u03B8)", sf::Color::Magenta, font));
-            arrows.push_back(new ForceArrow("Friccion", "\u03bc * N1", sf::Color::Cyan, font));
-            arrows.push_back(new ForceArrow("Tension", "T", sf::Color::Green, font));
-        } else {
-            arrows.push_back(new ForceArrow("Peso (W2)", "m2 * g", sf::Color::Red, font));
-            arrows.push_back(new ForceArrow("Tension", "T", sf::Color::Green, font, "Tension cuerda = T"));
+    ~LevelArena() {
+        for (Node* n = last; n; n = n->prev) n->destroy(reinterpret_cast<char*>(n) + sizeof(Node));
+        while (chunks) {
+            Chunk* next = chunks->next;
+            ::operator delete(chunks);
+            chunks = next;
         }
     }
 
-    ~Block() {
-        for (auto a : arrows) delete a;
-        arrows.clear();
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* p = allocate(sizeof(T), alignof(T));
+        T* object = new (p) T(std::forward<Args>(args)...);
+        link(p, &destroyObject<T>);
+        return object;
     }
 
-    void clearArrows() {
-        for (auto &a : arrows) a->update(shape.getPosition(), sf::Vector2f(0,0), 0.0f, 1.0f);
+    std::size_t getObjectCount() const { return objectCount; }
+    std::size_t getUsedBytes() const {
+        std::size_t u = 0;
+        for (const Chunk* c = chunks; c; c = c->next) u += c->used;
+        return u;
+    }
+    std::size_t getCapacityBytes() const {
+        std::size_t cap = 0;
+        for (const Chunk* c = chunks; c; c = c->next) cap += sizeof(Chunk) + c->capacity;
+        return cap;
     }
 
-    void updatePhysics(float m, float thetaDeg, float tensionMag, float frictionMag, bool frictionUpSlope) {
-        mass = m;
-        float thetaRad = toRad(thetaDeg);
-        float w = mass * G;
-        float scale = 2.0f;
+    // Los objetos ya los declara cada propietario; aqui solo va la reserva que sobra
+    void reportMemory(MemoryReport& report, const std::string& owner) const {
+        report.add("Arenas", owner + ": reservado sin usar", getCapacityBytes() - getUsedBytes(), 0);
+    }
+};
 
-        if (isOnSlope) {
-            sf::Vector2f downSlope(std::cos(thetaRad), std::sin(thetaRad));
-            sf::Vector2f upSlope(-std::cos(thetaRad), -std::sin(thetaRad));
-            sf::Vector2f normalDir(-std::sin(thetaRad), std::cos(thetaRad));
-            sf::Vector2f gravityDir(0, 1);
+// Con holgura sobre lo que ocupa hoy cada nivel (~11 KB el nivel 1), para que montar y
+// desmontar un nivel sea una sola reserva
+const std::size_t LEVEL_ARENA_BYTES = 16 * 1024;
+const std::size_t MENU_ARENA_BYTES = 2 * 1024;
 
-            arrows[0]->update(shape.getPosition(), gravityDir, w, scale);
-            arrows[1]->update(shape.getPosition(), normalDir, w * std::cos(thetaRad), scale);
-            arrows[2]->update(shape.getPosition(), downSlope, w * std::sin(thetaRad), scale);
+// ----------------- Fuente embebida (atlas pre-rasterizado) -----------------
+// Los glifos se rasterizan al compilar (fontbake) y se embeben en el binario,
+// asi en ejecucion no hay lectura de .ttf ni FreeType.
+class BakedFont {
+private:
+    sf::Texture texture;
+    std::unordered_map<sf::Uint64, const BakedGlyphEntry*> glyphs;
 
-            sf::Vector2f fDir = frictionUpSlope ? upSlope : downSlope;
-            arrows[3]->update(shape.getPosition(), fDir, frictionMag, scale);
+    static sf::Uint64 key(unsigned int size, sf::Uint32 cp) { return (static_cast<sf::Uint64>(size) << 32) | cp; }
 
-            arrows[4]->update(shape.getPosition(), upSlope, tensionMag, scale);
+public:
+    bool loadEmbedded() {
+        sf::Image image;
+        image.create(FONT_ATLAS_WIDTH, FONT_ATLAS_HEIGHT, sf::Color(255, 255, 255, 0));
+        for (unsigned int y = 0; y < FONT_ATLAS_HEIGHT; ++y)
+            for (unsigned int x = 0; x < FONT_ATLAS_WIDTH; ++x)
+                image.setPixel(x, y, sf::Color(255, 255, 255, FONT_ATLAS_ALPHA[y * FONT_ATLAS_WIDTH + x]));
+
+        if (!texture.loadFromImage(image)) return false;
+        texture.setSmooth(true);
+
+        for (const BakedGlyphEntry& g : FONT_ATLAS_GLYPHS) glyphs[key(g.size, g.codepoint)] = &g;
+        return true;
+    }
 
-        } else {
-            arrows[0]->update(shape.getPosition(), sf::Vector2f(0,1), w, scale);
-            arrows[1]->update(shape.getPosition(), sf::Vector2f(0,-1), tensionMag, scale);
+    // Tamaño horneado mas cercano al pedido; el texto se escala si no coincide exactamente
+    unsigned int nearestSize(unsigned int size) const {
+        unsigned int best = FONT_ATLAS_SIZES[0].size;
+        for (const BakedSizeEntry& e : FONT_ATLAS_SIZES) {
+            if (std::abs(static_cast<int>(e.size) - static_cast<int>(size)) < std::abs(static_cast<int>(best) - static_cast<int>(size))) best = e.size;
         }
+        return best;
     }
 
-    void draw(sf::RenderWindow& window) {
-        window.draw(shape);
-        for (auto a : arrows) a->draw(window);
+    float getLineSpacing(unsigned int bakedSize) const {
+        for (const BakedSizeEntry& e : FONT_ATLAS_SIZES) if (e.size == bakedSize) return e.lineSpacing;
+        return static_cast<float>(bakedSize);
     }
 
-    void handleHover(sf::Vector2f mouse) {
-        for (auto a : arrows) a->checkHover(mouse);
+    // Devuelve nullptr si el caracter no esta en el atlas
+    const BakedGlyphEntry* getGlyph(sf::Uint32 cp, unsigned int bakedSize) const {
+        auto it = glyphs.find(key(bakedSize, cp));
+        if (it != glyphs.end()) return it->second;
+        it = glyphs.find(key(bakedSize, '?'));
+        return (it != glyphs.end()) ? it->second : nullptr;
     }
 
-    void handleClick(sf::Vector2f mouse, Tooltip& tooltip) {
-        for (auto a : arrows) a->handleClick(mouse, tooltip);
+    const sf::Texture& getTexture() const { return texture; }
+
+    // Textura del atlas repartida por tamaño de caracter segun el area de sus glifos
+    void reportMemory(MemoryReport& report) const {
+        std::size_t used = 0;
+        for (const BakedSizeEntry& e : FONT_ATLAS_SIZES) {
+            std::size_t area = 0, count = 0;
+            for (const BakedGlyphEntry& g : FONT_ATLAS_GLYPHS) {
+                if (g.size != e.size) continue;
+                area += static_cast<std::size_t>(g.w) * g.h;
+                ++count;
+            }
+            used += area;
+            report.add("Fuente", "Textura glifos " + std::to_string(e.size) + " px", area * 4, count);
+        }
+        sf::Vector2u size = texture.getSize();
+        std::size_t textureBytes = static_cast<std::size_t>(size.x) * size.y * 4;
+        report.add("Fuente", "Textura relleno del atlas", textureBytes > used * 4 ? textureBytes - used * 4 : 0);
+        report.add("Fuente", "Indice de glifos", glyphs.size() * (sizeof(sf::Uint64) + sizeof(void*) * 2), glyphs.size());
+        report.add("Fuente", "Atlas embebido (binario)", sizeof(FONT_ATLAS_ALPHA) + sizeof(FONT_ATLAS_GLYPHS));
     }
 };
 
-// ----------------- Clase Base para Simuladores -----------------
-class SimulationBase {
-protected:
-    sf::Font& font;
-    sf::Text msgLabel;
-    Button* btnMenu;
+// Resultado del layout de un texto: quads de glifos (sin color) y sus limites locales.
+struct TextRun {
+    std::vector<sf::Vertex> quads;
+    sf::FloatRect bounds;
+};
 
-public:
-    SimulationBase(sf::Font& f) : font(f) {
-        msgLabel.setFont(font);
-        msgLabel.setCharacterSize(20);
-        msgLabel.setFillColor(sf::Color::Black);
+void layoutTextRun(const BakedFont& font, const sf::String& string, unsigned int characterSize, TextRun& run) {
+    run.quads.clear();
+    run.bounds = sf::FloatRect();
+    if (string.isEmpty()) return;
+
+    unsigned int bakedSize = font.nearestSize(characterSize);
+    float scale = static_cast<float>(characterSize) / static_cast<float>(bakedSize);
+    float lineSpacing = font.getLineSpacing(bakedSize) * scale;
+
+    float x = 0.f;
+    float y = static_cast<float>(characterSize);
+    float minX = static_cast<float>(characterSize), minY = static_cast<float>(characterSize);
+    float maxX = 0.f, maxY = 0.f;
+
+    for (std::size_t i = 0; i < string.getSize(); ++i) {
+        sf::Uint32 cp = string[i];
+        if (cp == '\r') continue;
+        if (cp == '\n') {
+            y += lineSpacing;
+            x = 0.f;
+            continue;
+        }
 
-        btnMenu = new Button(800.f, 20.f, 180.f, 40.f, "Volver al Menu", font, sf::Color(100, 100, 100));
-    }
-    virtual ~SimulationBase() { delete btnMenu; }
-    
-    virtual int handleEvents(const sf::Event& event, sf::RenderWindow& window) = 0;
-    virtual void update(sf::RenderWindow& window) = 0;
-    virtual void draw(sf::RenderWindow& window) = 0;
-    
-    int checkMenuClick(sf::Vector2f mousePos) {
-        if (btnMenu->isClicked(mousePos)) return 0; // 0 = Volver al Menú
-        return -1; // -1 = No se hizo clic en el menú
+        const BakedGlyphEntry* g = font.getGlyph(cp, bakedSize);
+        if (!g) continue;
+
+        if (g->w > 0 && g->h > 0) {
+            float left = x + g->left * scale;
+            float top = y + g->top * scale;
+            float right = left + g->width * scale;
+            float bottom = top + g->height * scale;
+
+            float u1 = static_cast<float>(g->u), v1 = static_cast<float>(g->v);
+            float u2 = static_cast<float>(g->u + g->w), v2 = static_cast<float>(g->v + g->h);
+
+            run.quads.push_back(sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u1, v1)));
+            run.quads.push_back(sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)));
+            run.quads.push_back(sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+            run.quads.push_back(sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+            run.quads.push_back(sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)));
+            run.quads.push_back(sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u2, v2)));
+
+            minX = std::min(minX, left); maxX = std::max(maxX, right);
+            minY = std::min(minY, top);  maxY = std::max(maxY, bottom);
+        }
+        x += g->advance * scale;
     }
-};
 
-// ----------------- Simulador Nivel 1 (Clase original, adaptada para la estructura base) -----------------
-class Simulator : public SimulationBase {
-// ... (Contenido de Simulator)
+    if (!run.quads.empty()) run.bounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+// Cache LRU compartida por todos los widgets: un mismo texto con la misma fuente y tamaño
+// ("49.0 N", valores de sliders cuantizados...) solo se maqueta una vez.
+// La "fuente" hace de estilo en la clave: el atlas solo hornea el estilo regular.
+class TextRunCache {
 private:
-    InputBox* inputM1;
-    InputBox* inputM2;
-    InputBox* inputMu;
-    Slider* sliderM1;
-    Slider* sliderM2;
-    Slider* sliderMu;
-    Button* btnTest;
-    Button* btnReset;
-    Tooltip* tooltip;
-    sf::Text labels[8];
+    struct Key {
+        const BakedFont* font;
+        unsigned int characterSize;
+        std::basic_string<sf::Uint32> text;
+        bool operator==(const Key& o) const { return font == o.font && characterSize == o.characterSize && text == o.text; }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const {
+            std::size_t h = 0;
+            for (sf::Uint32 c : k.text) h = h * 31 + c;
+            return h ^ (std::hash<const void*>()(k.font) + k.characterSize * 0x9e3779b9u);
+        }
+    };
+    typedef std::list<std::pair<Key, TextRun>> EntryList;
 
-    sf::ConvexShape ramp;
-    sf::CircleShape pulley;
-    sf::VertexArray rope;
+    EntryList entries; // Frente = usado mas recientemente
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    std::size_t capacity;
+    std::size_t hits, misses, evictions;
 
-    Block* blockYellow;
-    Block* blockOrange;
+public:
+    explicit TextRunCache(std::size_t cap = 512) : capacity(cap), hits(0), misses(0), evictions(0) {}
 
-    int currentAngle;
-    int attempts;
-    bool simulationActive;
-    std::string message;
-    float MU; 
-    bool isWon;
-
-public:
-    Simulator(sf::Font& font) : SimulationBase(font), rope(sf::LineStrip), MU(0.2f), isWon(false) {
-        setupUI();
-        resetGame();
+    static TextRunCache& shared() {
+        static TextRunCache cache;
+        return cache;
     }
 
-    ~Simulator() override {
-        delete inputM1;
-        delete inputM2;
-        delete inputMu;
-        delete sliderM1;
-        delete sliderM2;
-        delete sliderMu;
-        delete btnTest;
-        delete btnReset;
-        delete tooltip;
-        delete blockYellow;
-        delete blockOrange;
+    const TextRun& get(const BakedFont& font, const sf::String& string, unsigned int characterSize) {
+        Key key{&font, characterSize, string.toUtf32()};
+        auto it = index.find(key);
+        if (it != index.end()) {
+            ++hits;
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
+        }
+
+        ++misses;
+        if (entries.size() >= capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+            ++evictions;
+        }
+        entries.emplace_front(key, TextRun());
+        layoutTextRun(font, string, characterSize, entries.front().second);
+        index[key] = entries.begin();
+        return entries.front().second;
     }
-    
-    bool getIsWon() const { return isWon; }
 
-    void updateInputFromSlider(InputBox* input, float value, int precision) {
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(precision) << value;
-        input->setString(ss.str());
+    std::size_t getHits() const { return hits; }
+    std::size_t getMisses() const { return misses; }
+    std::size_t getEvictions() const { return evictions; }
+    std::size_t size() const { return entries.size(); }
+
+    void reportMemory(MemoryReport& report) const {
+        std::size_t bytes = 0;
+        for (const auto& e : entries) {
+            bytes += sizeof(e) + e.first.text.capacity() * sizeof(sf::Uint32) + e.second.quads.capacity() * sizeof(sf::Vertex);
+        }
+        bytes += index.size() * (sizeof(Key) + sizeof(EntryList::iterator)) + index.bucket_count() * sizeof(void*);
+        report.add("Caches", "TextRunCache", bytes, entries.size());
     }
+};
 
+// ----------------- Formato numerico sin asignaciones -----------------
+// Textos cortos con numeros y unidades ("49.0 N", "120.50 N*cm", "35 kg", "80 cm") escritos
+// con std::to_chars en un buffer fijo de la pila: sin locale, sin stringstream y sin heap.
+// El redondeo coincide con std::fixed + std::setprecision. Si el texto no cabe se trunca.
+class TextBuffer {
+private:
+    static const std::size_t CAPACITY = 256;
+    char buffer[CAPACITY];
+    std::size_t length;
 
-    void setupUI() {
-        float input_x = 50.f;
-        float input_y1 = 50.f;
-        float input_y2 = 140.f;
-        float input_y3 = 230.f;
-        float input_w = 100.f;
-        float input_h = 30.f;
-        float slider_offset = 40.f; 
-        float slider_w = 200.f;
-        
-        inputM1 = new InputBox(input_x, input_y1, input_w, input_h, font);
-        inputM2 = new InputBox(input_x, input_y2, input_w, input_h, font);
-        inputMu = new InputBox(input_x, input_y3, input_w, input_h, font);
+public:
+    TextBuffer() : length(0) { buffer[0] = '\0'; }
 
-        sliderM1 = new Slider(input_x, input_y1 + slider_offset, slider_w, 0.5f, 100.0f, 5.0f, 
-            [this](float v){ this->updateInputFromSlider(this->inputM1, v, 2); }); 
-        
-        sliderM2 = new Slider(input_x, input_y2 + slider_offset, slider_w, 0.5f, 100.0f, 5.0f, 
-            [this](float v){ this->updateInputFromSlider(this->inputM2, v, 2); }); 
-            
-        sliderMu = new Slider(input_x, input_y3 + slider_offset, slider_w, 0.0f, 1.0f, 0.2f, 
-            [this](float v){ this->updateInputFromSlider(this->inputMu, v, 3); }); 
+    void clear() { length = 0; buffer[0] = '\0'; }
 
-        float button_x = 280.f;
-        float button_y = 50.f;
-        float message_y = 100.f;
-        
-        btnTest = new Button(button_x, button_y, 100, 30, "Probar", font, sf::Color(0,150,0));
-        btnReset = new Button(button_x + 120, button_y, 100, 30, "Reiniciar", font, sf::Color(200,100,0));
+    TextBuffer& append(const char* s) {
+        while (*s && length < CAPACITY - 1) buffer[length++] = *s++;
+        buffer[length] = '\0';
+        return *this;
+    }
+    TextBuffer& append(const std::string& s) { return append(s.c_str()); }
 
-        tooltip = new Tooltip(font);
+    TextBuffer& appendFixed(float value, int precision) {
+        std::to_chars_result r = std::to_chars(buffer + length, buffer + CAPACITY - 1, value, std::chars_format::fixed, precision);
+        if (r.ec == std::errc()) length = r.ptr - buffer;
+        buffer[length] = '\0';
+        return *this;
+    }
 
-        labels[0].setFont(font); labels[0].setString("Masa 1 (kg) (Amarillo):"); labels[0].setPosition(input_x, input_y1 - 25); labels[0].setCharacterSize(14); labels[0].setFillColor(sf::Color::Black);
-        labels[1].setFont(font); labels[1].setString("Masa 2 (kg) (Naranja):"); labels[1].setPosition(input_x, input_y2 - 25); labels[1].setCharacterSize(14); labels[1].setFillColor(sf::Color::Black);
-        labels[3].setFont(font); labels[3].setString("Coef. de friccion:"); labels[3].setPosition(input_x, input_y2 + 70); labels[3].setCharacterSize(14); labels[3].setFillColor(sf::Color::Black);
-        
-        msgLabel.setPosition(button_x, message_y);
+    // Representacion mas corta que vuelve a leerse como el mismo float
+    TextBuffer& appendShortest(float value) {
+        std::to_chars_result r = std::to_chars(buffer + length, buffer + CAPACITY - 1, value);
+        if (r.ec == std::errc()) length = r.ptr - buffer;
+        buffer[length] = '\0';
+        return *this;
+    }
 
+    TextBuffer& appendInt(int value) {
+        std::to_chars_result r = std::to_chars(buffer + length, buffer + CAPACITY - 1, value);
+        if (r.ec == std::errc()) length = r.ptr - buffer;
+        buffer[length] = '\0';
+        return *this;
+    }
 
-        blockYellow = new Block(true, sf::Color::Yellow, font);
-        blockOrange = new Block(false, sf::Color(255,165,0), font);
+    // Valor con unidad: appendQuantity(49.f, 1, "N") -> "49.0 N"
+    TextBuffer& appendQuantity(float value, int precision, const char* unit) {
+        return appendFixed(value, precision).append(" ").append(unit);
     }
 
-    void resetGame() {
-        std::vector<int> angles = {45, 30, 60, 16, 37, 53};
-        currentAngle = angles[std::rand() % angles.size()];
-        attempts = 3;
-        simulationActive = false;
-        isWon = false;
-        message = "Intentos restantes: 3";
-        msgLabel.setString(message);
-        msgLabel.setFillColor(sf::Color::Black);
+    const char* c_str() const { return buffer; }
+    const char* begin() const { return buffer; }
+    const char* end() const { return buffer + length; }
+    std::size_t size() const { return length; }
+};
 
-        sliderM1->setValue(5.0f);
-        sliderM2->setValue(5.0f);
-        sliderMu->setValue(0.2f);
+// Reemplazo de sf::Text que dibuja desde el atlas de BakedFont.
+// Mantiene la misma interfaz que usan los widgets (setFont, setString, setCharacterSize...).
+// El layout sale de TextRunCache; aqui solo se copian los quads y se aplica el color.
+class BitmapText : public sf::Drawable, public sf::Transformable {
+private:
+    const BakedFont* font;
+    sf::String string;
+    unsigned int characterSize;
+    sf::Color fillColor;
+    mutable sf::VertexArray vertices;
+    mutable sf::FloatRect bounds;
+    mutable bool geometryNeedUpdate;
+
+    void ensureGeometryUpdate() const {
+        if (!geometryNeedUpdate) return;
+        geometryNeedUpdate = false;
+        ALLOC_SCOPE(AllocSubsystem::TextLayout);
+
+        vertices.clear();
+        bounds = sf::FloatRect();
+        if (!font || string.isEmpty()) return;
+
+        const TextRun& run = TextRunCache::shared().get(*font, string, characterSize);
+        vertices.resize(run.quads.size());
+        for (std::size_t i = 0; i < run.quads.size(); ++i) {
+            vertices[i] = run.quads[i];
+            vertices[i].color = fillColor;
+        }
+        bounds = run.bounds;
+    }
 
-        inputM1->clear(); inputM1->setString("5.00");
-        inputM2->clear(); inputM2->setString("5.00");
-        inputMu->clear(); inputMu->setString("0.00");
-        MU = 0.2f;
+public:
+    BitmapText() : font(nullptr), characterSize(30), fillColor(sf::Color::White), vertices(sf::Triangles), geometryNeedUpdate(false) {}
 
-        blockYellow->clearArrows();
-        blockOrange->clearArrows();
-        tooltip->hide();
+    void setFont(const BakedFont& f) { font = &f; geometryNeedUpdate = true; }
 
-        setupGeometry();
+    void setString(const sf::String& s) {
+        if (string == s) return;
+        string = s;
+        geometryNeedUpdate = true;
     }
-    
-    // ... (El resto de la lógica de Simulator es la misma)
-    void setupGeometry() {
-        float px = 400.0f;
-        float py = 180.0f; 
-        float base = 400.0f;
-        float theta = toRad(currentAngle);
-        float h = base * std::tan(theta);
+    // Los literales del codigo fuente estan en UTF-8. Se decodifica directamente sobre
+    // string, reutilizando su capacidad, y solo se rehace la geometria si el texto cambia.
+    void setUtf8(const char* begin, const char* end) {
+        std::size_t i = 0;
+        bool same = true;
+        for (const char* p = begin; p < end && same; ++i) {
+            sf::Uint32 cp;
+            p = sf::Utf8::decode(p, end, cp);
+            same = i < string.getSize() && string[i] == cp;
+        }
+        if (same && i == string.getSize()) return;
 
-        if (h > 350) { h = 350; base = h / std::tan(theta); }
+        string.clear();
+        for (const char* p = begin; p < end; ) {
+            sf::Uint32 cp;
+            p = sf::Utf8::decode(p, end, cp);
+            string += sf::String(cp);
+        }
+        geometryNeedUpdate = true;
+    }
+    void setString(const std::string& s) { setUtf8(s.data(), s.data() + s.size()); }
+    void setString(const char* s) { setUtf8(s, s + std::strlen(s)); }
+    void setString(const TextBuffer& s) { setUtf8(s.begin(), s.end()); }
+
+    void setCharacterSize(unsigned int size) {
+        if (characterSize == size) return;
+        characterSize = size;
+        geometryNeedUpdate = true;
+    }
 
-        sf::Vector2f A(px, py);
-        sf::Vector2f B(px, py + h);
-        sf::Vector2f C(px + base, py + h);
+    void setFillColor(const sf::Color& color) {
+        if (fillColor == color) return;
+        fillColor = color;
+        if (!geometryNeedUpdate) {
+            for (std::size_t i = 0; i < vertices.getVertexCount(); ++i) vertices[i].color = fillColor;
+        }
+    }
 
-        float a = 30.0f;
-        if (currentAngle >= 60) a = 60.0f;
-        sf::Vector2f A2(px, py + a);
-        sf::Vector2f B2(px, py + a + h);
-        sf::Vector2f C2(px + base, py + a + h);
+    const sf::String& getString() const { return string; }
+    unsigned int getCharacterSize() const { return characterSize; }
 
-        ramp.setPointCount(3);
-        ramp.setPoint(0, A2);
-        ramp.setPoint(1, B2);
-        ramp.setPoint(2, C2);
-        ramp.setFillColor(sf::Color(150,150,150));
+    std::size_t getVertexCount() const {
+        ensureGeometryUpdate();
+        return vertices.getVertexCount();
+    }
+    const sf::VertexArray& getVertices() const {
+        ensureGeometryUpdate();
+        return vertices;
+    }
+    const sf::Texture* getTexture() const { return font ? &font->getTexture() : nullptr; }
+    const sf::Color& getFillColor() const { return fillColor; }
 
-        sf::Vector2f slopeDir = C - A;
-        float len = std::sqrt(slopeDir.x*slopeDir.x + slopeDir.y*slopeDir.y);
-        slopeDir /= len;
+    // Memoria dinamica propia (vertices y cadena), sin contar sizeof(BitmapText)
+    std::size_t getHeapBytes() const {
+        return vertices.getVertexCount() * sizeof(sf::Vertex) + string.getSize() * sizeof(sf::Uint32);
+    }
 
-        float distOnSlope = 0.45f * len;
-        sf::Vector2f blockYellowPos = A + slopeDir * distOnSlope;
+    sf::FloatRect getLocalBounds() const {
+        ensureGeometryUpdate();
+        return bounds;
+    }
 
-        blockYellow->shape.setPosition(blockYellowPos);
-        blockYellow->shape.setRotation(currentAngle);
+    sf::FloatRect getGlobalBounds() const { return getTransform().transformRect(getLocalBounds()); }
 
-        sf::Vector2f pulleyPos = A - slopeDir * 20.0f;
-        pulley.setRadius(15);
-        pulley.setOrigin(15,15);
-        pulley.setPosition(pulleyPos);
-        pulley.setFillColor(sf::Color(50,50,50));
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
+        if (!font) return;
+        ensureGeometryUpdate();
+        states.transform *= getTransform();
+        states.texture = &font->getTexture();
+        target.draw(vertices, states);
+    }
+};
 
-        sf::Vector2f blockOrangePos(pulleyPos.x, pulleyPos.y + 120.0f);
-        blockOrange->shape.setPosition(blockOrangePos);
+// ----------------- Conteo de draw calls -----------------
+// Capa entre los niveles y el sf::RenderTarget real que cuenta, por frame, draw calls,
+// vertices, cambios de textura y cambios de estado (textura/blend/shader) tal y como los
+// emitiria SFML. sf::RenderTarget::draw no es virtual, por eso es una fachada con una
+// sobrecarga por tipo de drawable en lugar de una subclase.
+struct RenderStats {
+    unsigned int drawCalls;
+    unsigned int vertices;
+    unsigned int textureBinds;
+    unsigned int stateChanges;
+
+    RenderStats() { reset(); }
+    void reset() { drawCalls = vertices = textureBinds = stateChanges = 0; }
+};
 
-        rope.clear();
-        rope.setPrimitiveType(sf::LineStrip);
-        rope.resize(3);
-        rope[0].position = blockYellowPos;
-        rope[1].position = pulleyPos;
-        rope[2].position = blockOrangePos;
-        rope[0].color = rope[1].color = rope[2].color = sf::Color::Black;
+// Copia inmutable de lo que se dibujo en un frame: las figuras (con su transform, colores y
+// puntos) y los vertices de textos, flechas y graficas, en orden. La graba el hilo de
+// simulacion y la dibuja el principal (--sim-thread), sin tocar los objetos de los niveles.
+// reset() conserva la capacidad, asi que en regimen estable grabar no reserva memoria.
+class DrawSnapshot {
+private:
+    enum class CommandKind : sf::Uint8 { Clear, Shape, Vertices };
+
+    struct Command {
+        CommandKind kind;
+        sf::PrimitiveType type;
+        sf::Color color;       // Clear
+        std::size_t index;     // Shape: hueco en shapes; Vertices: primer vertice
+        std::size_t count;     // Vertices
+        sf::RenderStates states;
+    };
+
+    std::vector<Command> commands;
+    std::vector<sf::ConvexShape> shapes; // Huecos reutilizados de un frame a otro
+    std::size_t shapeCount;
+    std::vector<sf::Vertex> vertices;
+
+    // Solo se llama a los setters que cambian algo: cada uno de puntos o grosor rehace la geometria
+    static void copyShape(sf::ConvexShape& dst, const sf::Shape& src) {
+        std::size_t points = src.getPointCount();
+        bool rebuild = dst.getPointCount() != points || dst.getOutlineThickness() != src.getOutlineThickness();
+        for (std::size_t i = 0; i < points && !rebuild; ++i) rebuild = dst.getPoint(i) != src.getPoint(i);
+        if (rebuild) {
+            dst.setPointCount(points);
+            for (std::size_t i = 0; i < points; ++i) dst.setPoint(i, src.getPoint(i));
+            dst.setOutlineThickness(src.getOutlineThickness());
+        }
+        if (dst.getTexture() != src.getTexture()) dst.setTexture(src.getTexture());
+        if (dst.getTextureRect() != src.getTextureRect()) dst.setTextureRect(src.getTextureRect());
+        if (dst.getFillColor() != src.getFillColor()) dst.setFillColor(src.getFillColor());
+        if (dst.getOutlineColor() != src.getOutlineColor()) dst.setOutlineColor(src.getOutlineColor());
+        dst.setPosition(src.getPosition());
+        dst.setRotation(src.getRotation());
+        dst.setScale(src.getScale());
+        dst.setOrigin(src.getOrigin());
     }
 
-    void calculatePhysics() {
-        float m1 = inputM1->getValue();
-        float m2 = inputM2->getValue();
-        float inMu = inputMu->getValue();
+public:
+    DrawSnapshot() : shapeCount(0) {}
 
-        MU = inMu; 
+    void reset() {
+        commands.clear();
+        vertices.clear();
+        shapeCount = 0;
+    }
 
-        if (m1 <= 0 || m2 <= 0) {
-            msgLabel.setString("Introduce masas validas (>0)");
-            msgLabel.setFillColor(sf::Color::Red);
-            return;
-        }
+    void clear(const sf::Color& color) {
+        Command c = {CommandKind::Clear, sf::Points, color, 0, 0, sf::RenderStates::Default};
+        commands.push_back(c);
+    }
 
-        float thetaRad = toRad(currentAngle);
-        float W1 = m1 * G;
-        float W2 = m2 * G;
-        float W1_para = W1 * std::sin(thetaRad);
-        float N1 = W1 * std::cos(thetaRad);
-        float Ff_max = MU * N1;
-        float Tension = W2;
+    void draw(const sf::Shape& shape, const sf::RenderStates& states) {
+        if (shapeCount == shapes.size()) shapes.emplace_back();
+        copyShape(shapes[shapeCount], shape);
+        Command c = {CommandKind::Shape, sf::Points, sf::Color(), shapeCount++, 0, states};
+        commands.push_back(c);
+    }
 
-        float netForce = W1_para - W2;
-        
-        bool frictionUp = (netForce > 0); 
-        
-        float actualFriction = 0.0f;
-        if (std::abs(netForce) < Ff_max + EPSILON) {
-            actualFriction = std::abs(netForce);
-            message = "EQUILIBRIO! GANASTE.";
-            msgLabel.setFillColor(sf::Color::Green);
-            simulationActive = true;
-            isWon = true; 
-        } else {
-            actualFriction = Ff_max;
+    void draw(const sf::Vertex* first, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states) {
+        if (count == 0) return;
+        Command c = {CommandKind::Vertices, type, sf::Color(), vertices.size(), count, states};
+        commands.push_back(c);
+        vertices.insert(vertices.end(), first, first + count);
+    }
 
-            attempts--;
-            if (attempts > 0) {
-                message = "No equilibrado. Intentos: " + std::to_string(attempts);
-                msgLabel.setFillColor(sf::Color::Red);
-            } else {
-                message = "Juego terminado. Fallaste.";
-                msgLabel.setFillColor(sf::Color::Red);
+    // Hilo principal: dibuja la copia tal cual se grabo
+    void replay(sf::RenderTarget& target) const {
+        for (const Command& c : commands) {
+            switch (c.kind) {
+                case CommandKind::Clear: target.clear(c.color); break;
+                case CommandKind::Shape: target.draw(shapes[c.index], c.states); break;
+                case CommandKind::Vertices: target.draw(&vertices[c.index], c.count, c.type, c.states); break;
             }
-            simulationActive = true;
-            isWon = false;
         }
+    }
 
-
-        blockYellow->updatePhysics(m1, currentAngle, Tension, actualFriction, frictionUp);
-        blockOrange->updatePhysics(m2, 0, Tension, 0, false);
-        
-        msgLabel.setString(message);
+    std::size_t getMemoryBytes() const {
+        return commands.capacity() * sizeof(Command) + shapes.capacity() * sizeof(sf::ConvexShape)
+             + vertices.capacity() * sizeof(sf::Vertex);
     }
-    
-    int handleEvents(const sf::Event& event, sf::RenderWindow& window) override {
-        sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
+};
 
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-            int menu_status = checkMenuClick(mousePos);
-            if (menu_status == 0) return 0;
+class CountingRenderTarget {
+private:
+    sf::RenderTarget* target;   // Dibuja directamente...
+    DrawSnapshot* snapshot;     // ...o graba en una copia para otro hilo
+    RenderStats& stats;
+    const sf::Texture* lastTexture;
+    sf::BlendMode lastBlend;
+    const sf::Shader* lastShader;
+
+    void record(std::size_t vertexCount, const sf::RenderStates& states) {
+        ++stats.drawCalls;
+        stats.vertices += static_cast<unsigned int>(vertexCount);
+        bool changed = false;
+        if (states.texture != lastTexture) {
+            if (states.texture) ++stats.textureBinds;
+            lastTexture = states.texture;
+            changed = true;
         }
+        if (states.blendMode != lastBlend) { lastBlend = states.blendMode; changed = true; }
+        if (states.shader != lastShader) { lastShader = states.shader; changed = true; }
+        if (changed) ++stats.stateChanges;
+    }
 
-        inputM1->handleEvent(event);
-        inputM2->handleEvent(event);
-        inputMu->handleEvent(event);
+public:
+    CountingRenderTarget(sf::RenderTarget& t, RenderStats& s) : target(&t), snapshot(nullptr), stats(s), lastTexture(nullptr), lastBlend(sf::BlendAlpha), lastShader(nullptr) {}
+    CountingRenderTarget(DrawSnapshot& d, RenderStats& s) : target(nullptr), snapshot(&d), stats(s), lastTexture(nullptr), lastBlend(sf::BlendAlpha), lastShader(nullptr) {}
 
-        sliderM1->handleEvent(event, mousePos);
-        sliderM2->handleEvent(event, mousePos);
-        sliderMu->handleEvent(event, mousePos);
+    // Al grabar no hay sf::RenderTarget: getTarget() solo es valido si isRecording() es false
+    bool isRecording() const { return snapshot != nullptr; }
+    sf::RenderTarget& getTarget() { return *target; }
+    RenderStats& getStats() { return stats; }
 
-        if (event.type == sf::Event::MouseButtonPressed) {
-            if (event.mouseButton.button == sf::Mouse::Left) {
-                inputM1->checkClick(mousePos);
-                inputM2->checkClick(mousePos);
-                inputMu->checkClick(mousePos);
+    void clear(const sf::Color& color) {
+        if (snapshot) snapshot->clear(color);
+        else target->clear(color);
+    }
 
-                if (btnReset->isClicked(mousePos)) resetGame();
-                if (btnTest->isClicked(mousePos) && attempts > 0 && !isWon) calculatePhysics();
+    // Relleno (TriangleFan) y, si tiene grosor, contorno (TriangleStrip): hasta dos draw calls
+    void draw(const sf::Shape& shape, const sf::RenderStates& states = sf::RenderStates::Default) {
+        std::size_t points = shape.getPointCount();
+        sf::RenderStates counted = states;
+        counted.texture = shape.getTexture();
+        record(points + 2, counted);
+        if (shape.getOutlineThickness() != 0.f) {
+            counted.texture = nullptr;
+            record((points + 1) * 2, counted);
+        }
+        if (snapshot) snapshot->draw(shape, states);
+        else target->draw(shape, states);
+    }
 
-                tooltip->hide();
-                if (simulationActive) {
-                    blockYellow->handleClick(mousePos, *tooltip);
-                    blockOrange->handleClick(mousePos, *tooltip);
-                }
-            } else {
-                tooltip->hide();
-            }
+    void draw(const BitmapText& text, const sf::RenderStates& states = sf::RenderStates::Default) {
+        if (text.getVertexCount() > 0) {
+            sf::RenderStates counted = states;
+            counted.texture = text.getTexture();
+            record(text.getVertexCount(), counted);
         }
-        
-        if (simulationActive) {
-            blockYellow->handleHover(mousePos);
-            blockOrange->handleHover(mousePos);
+        if (!snapshot) {
+            target->draw(text, states);
+        } else if (text.getTexture()) {
+            sf::RenderStates copied = states;
+            copied.transform *= text.getTransform();
+            copied.texture = text.getTexture();
+            const sf::VertexArray& v = text.getVertices();
+            if (v.getVertexCount() > 0) snapshot->draw(&v[0], v.getVertexCount(), v.getPrimitiveType(), copied);
         }
-        
-        return 1; 
     }
 
-    void update(sf::RenderWindow& window) override {} 
-    
-    void draw(sf::RenderWindow& window) override {
-        window.clear(sf::Color(240,240,240));
+    void draw(const sf::Sprite& sprite, const sf::RenderStates& states = sf::RenderStates::Default) {
+        sf::RenderStates counted = states;
+        counted.texture = sprite.getTexture();
+        record(4, counted);
+        if (!snapshot) {
+            target->draw(sprite, states);
+            return;
+        }
+        // Mismo quad (TriangleStrip) que arma sf::Sprite
+        sf::IntRect rect = sprite.getTextureRect();
+        float w = static_cast<float>(std::abs(rect.width));
+        float h = static_cast<float>(std::abs(rect.height));
+        float left = static_cast<float>(rect.left);
+        float top = static_cast<float>(rect.top);
+        float right = left + rect.width;
+        float bottom = top + rect.height;
+        sf::Color color = sprite.getColor();
+        sf::Vertex quad[4] = {
+            sf::Vertex(sf::Vector2f(0.f, 0.f), color, sf::Vector2f(left, top)),
+            sf::Vertex(sf::Vector2f(0.f, h), color, sf::Vector2f(left, bottom)),
+            sf::Vertex(sf::Vector2f(w, 0.f), color, sf::Vector2f(right, top)),
+            sf::Vertex(sf::Vector2f(w, h), color, sf::Vector2f(right, bottom))
+        };
+        counted = states;
+        counted.transform *= sprite.getTransform();
+        counted.texture = sprite.getTexture();
+        snapshot->draw(quad, 4, sf::TriangleStrip, counted);
+    }
 
-        window.draw(ramp);
-        if (rope.getVertexCount() > 0) window.draw(rope);
-        window.draw(pulley);
+    void draw(const sf::VertexArray& vertices, const sf::RenderStates& states = sf::RenderStates::Default) {
+        if (vertices.getVertexCount() > 0) record(vertices.getVertexCount(), states);
+        if (!snapshot) target->draw(vertices, states);
+        else if (vertices.getVertexCount() > 0) snapshot->draw(&vertices[0], vertices.getVertexCount(), vertices.getPrimitiveType(), states);
+    }
 
-        sf::Text angTxt;
-        angTxt.setFont(font);
-        angTxt.setString(std::to_string(currentAngle) + "\u00B0"); 
-        angTxt.setPosition(ramp.getPoint(2).x - 60, ramp.getPoint(2).y - 30);
-        angTxt.setFillColor(sf::Color::Black);
-        angTxt.setCharacterSize(16);
-        window.draw(angTxt);
+    void draw(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states = sf::RenderStates::Default) {
+        if (count > 0) record(count, states);
+        if (snapshot) snapshot->draw(vertices, count, type, states);
+        else target->draw(vertices, count, type, states);
+    }
+
+    // El contenido de un VBO no se puede copiar al grabar: quien lo use debe dibujar sus
+    // vertices cuando isRecording() (ver ArrowBatch)
+    void draw(const sf::VertexBuffer& buffer, std::size_t first, std::size_t count, const sf::RenderStates& states = sf::RenderStates::Default) {
+        if (count > 0) record(count, states);
+        if (!snapshot) target->draw(buffer, first, count, states);
+    }
+};
+
+// ----------------- UI / Utility (Clases originales) -----------------
+// ... (Tooltip, ForceArrow, InputBox, Button, Slider - sin cambios relevantes en estas clases)
+// ... (Las definiciones de estas clases se mantienen igual que en el código anterior)
+
+// ForceArrow (Mantengo la clase completa para referencia, aunque el cuerpo es el mismo)
+class Tooltip {
+// ... (Contenido de Tooltip)
+private:
+    sf::RectangleShape background;
+    BitmapText textInfo;
+    bool visible;
+public:
+    Tooltip(BakedFont& font) {
+        background.setFillColor(sf::Color(50, 50, 50, 230));
+        background.setOutlineColor(sf::Color::White);
+        background.setOutlineThickness(1);
 
-        blockYellow->draw(window);
-        blockOrange->draw(window);
+        textInfo.setFont(font);
+        textInfo.setCharacterSize(14);
+        textInfo.setFillColor(sf::Color::White);
+        visible = false;
+    }
 
-        inputM1->draw(window);
-        inputM2->draw(window);
-        inputMu->draw(window);
+    void show(const std::string& name, const std::string& formula, float value, sf::Vector2f pos, const std::string& extra = "") {
+        TRACE_SCOPE("Tooltip::show");
+        TextBuffer buf;
+        
+        if (extra == "Seesaw") { 
+            buf.append("Momento: ").append(name).append("\n");
+            buf.append("Formula: ").append(formula).append("\n");
+            buf.append("Valor: ").appendQuantity(value, 2, "N*cm");
+        } else { 
+            buf.append("Fuerza: ").append(name).append("\n");
+            buf.append("Formula: ").append(formula).append("\n");
+            buf.append("Valor: ").appendQuantity(value, 2, "N");
+            if (!extra.empty()) buf.append("\n(").append(extra).append(")");
+        }
+        
 
-        btnTest->draw(window);
-        btnReset->draw(window);
-        btnMenu->draw(window); 
+        textInfo.setString(buf);
+        sf::FloatRect bounds = textInfo.getGlobalBounds();
+        background.setSize(sf::Vector2f(bounds.width + 20, bounds.height + 20));
+        background.setPosition(pos);
+        textInfo.setPosition(pos.x + 10, pos.y + 10);
+        visible = true;
+        LatencyTracker::instance().noteChange(LatencyKind::Tooltip);
+    }
 
-        sliderM1->draw(window);
-        sliderM2->draw(window);
-        sliderMu->draw(window);
+    void hide() { visible = false; }
+    bool isVisible() const { return visible; }
 
-        for (int i = 0; i < 6; ++i) window.draw(labels[i]);
-        window.draw(msgLabel); 
+    std::size_t getMemoryBytes() const { return sizeof(*this) + textInfo.getHeapBytes(); }
 
-        tooltip->draw(window);
+    void draw(CountingRenderTarget& target) {
+        if (visible) { target.draw(background); target.draw(textInfo); }
     }
 };
 
-// ----------------- Simulador Nivel 2 (NUEVA CLASE: Sube y Baja - MODIFICADA) -----------------
+// Malla de flecha unitaria compartida: cada vertice se expresa como
+// (fraccion de la longitud, desplazamiento fijo a lo largo, desplazamiento lateral),
+// asi el cuerpo se estira con la magnitud y la punta mantiene su tamaño.
+struct ArrowMeshVertex { float along; float offset; float side; };
+
+const ArrowMeshVertex ARROW_MESH[] = {
+    // Cuerpo (rectangulo de 4 px de grosor, dos triangulos)
+    {0.f, 0.f, -2.f}, {1.f, 0.f, -2.f}, {1.f, 0.f, 2.f},
+    {0.f, 0.f, -2.f}, {1.f, 0.f, 2.f},  {0.f, 0.f, 2.f},
+    // Punta
+    {1.f, 0.f, 0.f}, {1.f, -10.f, -6.f}, {1.f, -10.f, 6.f}
+};
+const std::size_t ARROW_MESH_SIZE = sizeof(ARROW_MESH) / sizeof(ARROW_MESH[0]);
 
-class SeesawSimulator : public SimulationBase {
+// Acumula los cuerpos de todas las flechas del frame y los dibuja con un solo
+// sf::VertexBuffer (uso Stream). Si el driver no soporta VBOs, o si se graba la copia del
+// frame para otro hilo, se dibuja el arreglo directamente.
+class ArrowBatch {
 private:
-    // Geometría
-    sf::RectangleShape board; 
-    sf::CircleShape pivot;    
-    sf::RectangleShape base;   
-    
-    // Figuras/Personas
-    sf::CircleShape person1;
-    sf::CircleShape person2;
-
-    // UI
-    InputBox* inputWeightP2;
-    Button* btnCalculate;
-    Button* btnNewGame;
-    Tooltip* tooltip;
-    
-    // Flechas de fuerza (momento)
-    ForceArrow* forceP1;
-    ForceArrow* forceP2;
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer;
+public:
+    ArrowBatch() : buffer(sf::Triangles, sf::VertexBuffer::Stream) {}
 
-    // Parámetros de juego
-    float weightP1, weightP2_input;
-    int distP1, distP2; // <-- Ahora enteros (cm)
-    float momentP1, momentP2;
-    float correctWeightP2; // <-- Respuesta precalculada
-    bool isWon;
-    
-    // Constantes Visuales
-    const float BOARD_WIDTH = 600.f;
-    const float BOARD_HEIGHT = 20.f;
-    const float PIVOT_X = 500.f; 
-    const float PIVOT_Y = 550.f; 
+    void clear() { vertices.clear(); }
 
-public:
-    SeesawSimulator(sf::Font& font) : SimulationBase(font), isWon(false) {
-        setupUI();
-        setupGeometry();
-        resetGame();
+    void add(sf::Vector2f start, sf::Vector2f dirUnit, float length, sf::Color color) {
+        sf::Vector2f normal(-dirUnit.y, dirUnit.x);
+        for (std::size_t i = 0; i < ARROW_MESH_SIZE; ++i) {
+            const ArrowMeshVertex& v = ARROW_MESH[i];
+            float a = v.along * length + v.offset;
+            vertices.push_back(sf::Vertex(start + dirUnit * a + normal * v.side, color));
+        }
     }
-    
-    ~SeesawSimulator() override {
-        delete inputWeightP2;
-        delete btnCalculate;
-        delete btnNewGame;
-        delete tooltip;
-        delete forceP1;
-        delete forceP2;
+
+    void reportMemory(MemoryReport& report, const std::string& owner) const {
+        report.add("Vertices y texturas", owner + ": lote de flechas (CPU)", vertices.capacity() * sizeof(sf::Vertex));
+        report.add("Vertices y texturas", owner + ": lote de flechas (GPU)", buffer.getVertexCount() * sizeof(sf::Vertex));
     }
-    
-    bool getIsWon() const { return isWon; }
 
-    // Generar un número entero aleatorio en el rango [min, max]
-    int randomInt(int min, int max) {
+    void draw(CountingRenderTarget& target) {
+        if (vertices.empty()) return;
+
+        if (!sf::VertexBuffer::isAvailable() || target.isRecording()) {
+            target.draw(vertices.data(), vertices.size(), sf::Triangles);
+            return;
+        }
+
+        if (buffer.getVertexCount() < vertices.size()) {
+            buffer.create(std::max(vertices.size(), buffer.getVertexCount() * 2));
+        }
+        buffer.update(vertices.data(), vertices.size(), 0);
+        target.draw(buffer, 0, vertices.size());
+    }
+};
+
+// ----------------- Indice espacial para hit testing -----------------
+// Caja orientada (centro, eje unitario y semiejes). Los widgets son cajas alineadas;
+// las flechas se alinean con su direccion, asi una flecha diagonal no captura el raton
+// en todo su rectangulo envolvente.
+struct HitShape {
+    sf::Vector2f center;
+    sf::Vector2f axis;
+    float halfLength, halfWidth;
+
+    static HitShape fromRect(const sf::FloatRect& r) {
+        return HitShape{sf::Vector2f(r.left + r.width / 2.f, r.top + r.height / 2.f), sf::Vector2f(1.f, 0.f), r.width / 2.f, r.height / 2.f};
+    }
+
+    bool contains(sf::Vector2f p) const {
+        sf::Vector2f d = p - center;
+        float along = d.x * axis.x + d.y * axis.y;
+        float across = -d.x * axis.y + d.y * axis.x;
+        return std::abs(along) <= halfLength && std::abs(across) <= halfWidth;
+    }
+
+    sf::FloatRect getBounds() const {
+        float ex = std::abs(axis.x) * halfLength + std::abs(axis.y) * halfWidth;
+        float ey = std::abs(axis.y) * halfLength + std::abs(axis.x) * halfWidth;
+        return sf::FloatRect(center.x - ex, center.y - ey, ex * 2.f, ey * 2.f);
+    }
+};
+
+// Rejilla uniforme sobre el espacio logico 1000x700: cada celda guarda los elementos cuya
+// caja envolvente la toca (en orden de insercion). Se reconstruye solo cuando algo se mueve;
+// una consulta mira una celda y hace la prueba exacta con sus pocos candidatos.
+class HitGrid {
+private:
+    static constexpr float CELL = 50.f;
+    static const int COLS = 20;
+    static const int ROWS = 14;
+
+    struct Item { HitShape shape; int id; };
+
+    std::vector<Item> items;
+    std::vector<int> cellStart; // COLS * ROWS + 1 desplazamientos en cellItems
+    std::vector<int> cellItems;
+
+    static int col(float x) { return std::max(0, std::min(COLS - 1, static_cast<int>(std::floor(x / CELL)))); }
+    static int row(float y) { return std::max(0, std::min(ROWS - 1, static_cast<int>(std::floor(y / CELL)))); }
+
+    template <typename F>
+    void forEachCell(const sf::FloatRect& b, F f) const {
+        for (int r = row(b.top); r <= row(b.top + b.height); ++r)
+            for (int c = col(b.left); c <= col(b.left + b.width); ++c) f(r * COLS + c);
+    }
+
+public:
+    HitGrid() : cellStart(COLS * ROWS + 1, 0) {}
+
+    void clear() { items.clear(); }
+    void add(int id, const HitShape& shape) { items.push_back(Item{shape, id}); }
+
+    void build() {
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        for (const Item& it : items) forEachCell(it.shape.getBounds(), [&](int cell) { ++cellStart[cell + 1]; });
+        for (int i = 0; i < COLS * ROWS; ++i) cellStart[i + 1] += cellStart[i];
+
+        cellItems.resize(cellStart.back());
+        std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < static_cast<int>(items.size()); ++i)
+            forEachCell(items[i].shape.getBounds(), [&](int cell) { cellItems[fill[cell]++] = i; });
+    }
+
+    // Llama a f(id) por cada elemento que contiene p, en orden de insercion
+    template <typename F>
+    void forEachAt(sf::Vector2f p, F f) const {
+        int cell = row(p.y) * COLS + col(p.x);
+        for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+            const Item& it = items[cellItems[k]];
+            if (it.shape.contains(p)) f(it.id);
+        }
+    }
+
+    // Id del ultimo elemento añadido que contiene p (el de encima), -1 si ninguno
+    int queryPoint(sf::Vector2f p) const {
+        int hit = -1;
+        forEachAt(p, [&](int id) { hit = id; });
+        return hit;
+    }
+};
+
+// Flechas de fuerza de un cuerpo en estructura de arrays: lo que se toca en cada
+// actualizacion, hover y dibujo (origen, direccion, longitud, magnitud, hover) va en arrays
+// contiguos; nombre, formula, descripcion y etiquetas van aparte y solo se leen al mostrar
+// un tooltip o al redibujar el texto.
+class ForceArrowSet {
+private:
+    // Datos calientes, uno por flecha
+    std::vector<sf::Vector2f> start;
+    std::vector<sf::Vector2f> dirUnit;
+    std::vector<float> vizLength;
+    std::vector<float> magnitude;
+    std::vector<unsigned char> hovered;
+    std::vector<sf::Color> baseColor;
+
+    // Datos frios
+    struct ArrowInfo {
+        std::string name;
+        std::string formula;
+        std::string extraDesc;
+    };
+    std::vector<ArrowInfo> info;
+    std::vector<BitmapText> labels;
+    const BakedFont* font;
+
+public:
+    explicit ForceArrowSet(BakedFont& f, std::size_t capacity = 0) : font(&f) { reserve(capacity); }
+
+    void reserve(std::size_t n) {
+        start.reserve(n);
+        dirUnit.reserve(n);
+        vizLength.reserve(n);
+        magnitude.reserve(n);
+        hovered.reserve(n);
+        baseColor.reserve(n);
+        info.reserve(n);
+        labels.reserve(n);
+    }
+
+    // Devuelve el indice de la nueva flecha
+    int add(const std::string& n, const std::string& form, sf::Color c, const std::string& extra = "") {
+        start.push_back(sf::Vector2f());
+        dirUnit.push_back(sf::Vector2f(1, 0));
+        vizLength.push_back(0.0f);
+        magnitude.push_back(0.0f);
+        hovered.push_back(0);
+        baseColor.push_back(c);
+        info.push_back(ArrowInfo{n, form, extra});
+        labels.push_back(BitmapText());
+        labels.back().setFont(*font);
+        labels.back().setCharacterSize(12);
+        labels.back().setFillColor(sf::Color::Black);
+        return static_cast<int>(start.size() - 1);
+    }
+
+    std::size_t size() const { return start.size(); }
+
+    void update(std::size_t i, sf::Vector2f startPos, sf::Vector2f direction, float magValue, float scale) {
+        TRACE_SCOPE("ForceArrowSet::update");
+        updateGeometry(i, startPos, direction, magValue, scale);
+        updateLabel(i);
+    }
+
+    // Solo posicion, direccion y longitud visual; no toca la etiqueta
+    void updateGeometry(std::size_t i, sf::Vector2f startPos, sf::Vector2f direction, float magValue, float scale) {
+        magnitude[i] = magValue;
+        start[i] = startPos;
+
+        if (magValue < 0.05f) {
+            vizLength[i] = 0.0f;
+            return;
+        }
+
+        float dirLen = std::sqrt(direction.x*direction.x + direction.y*direction.y);
+        dirUnit[i] = (dirLen > 0.0001f) ? (direction / dirLen) : sf::Vector2f(1,0);
+
+        vizLength[i] = std::min(std::max(magValue * scale, 30.f), 160.f);
+    }
+
+    void updateLabel(std::size_t i) {
+        if (magnitude[i] < 0.05f) {
+            labels[i].setString("");
+            return;
+        }
+
+        TextBuffer buf;
+        buf.appendQuantity(magnitude[i], 1, "N");
+        labels[i].setString(buf);
+        labels[i].setPosition(start[i] + dirUnit[i] * vizLength[i] + sf::Vector2f(10, 8));
+    }
+
+    // Todas a cero en el mismo origen (antes de lanzar la simulacion)
+    void clear(sf::Vector2f origin) {
+        for (std::size_t i = 0; i < size(); ++i) update(i, origin, sf::Vector2f(0,0), 0.0f, 1.0f);
+    }
+
+    // Caja orientada con la flecha: cuerpo de 4 px con margen de 6 px (cubre tambien la punta)
+    HitShape getHitShape(std::size_t i) const {
+        return HitShape{start[i] + dirUnit[i] * (vizLength[i] / 2.f), dirUnit[i], vizLength[i] / 2.f + 6.f, 8.f};
+    }
+
+    bool isHittable(std::size_t i) const { return vizLength[i] > 0.0f; }
+
+    // Recorrido lineal sobre los arrays calientes
+    void updateHover(sf::Vector2f mousePos) {
+        for (std::size_t i = 0; i < size(); ++i) hovered[i] = isHittable(i) && getHitShape(i).contains(mousePos);
+    }
+
+    void clearHover() { std::fill(hovered.begin(), hovered.end(), 0); }
+    void setHovered(std::size_t i, bool h) { hovered[i] = h; }
+    bool getIsHovered(std::size_t i) const { return hovered[i] != 0; }
+
+    void handleClick(std::size_t i, sf::Vector2f mousePos, Tooltip& tooltip, const std::string& extra = "") {
+        if (hovered[i]) tooltip.show(info[i].name, info[i].formula, magnitude[i], mousePos, extra);
+    }
+
+    // Los cuerpos van al lote compartido; las etiquetas se dibujan aparte, despues del lote.
+    void draw(ArrowBatch& batch) const {
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (magnitude[i] <= 0.05f) continue;
+            sf::Color c = baseColor[i];
+            sf::Color drawColor = hovered[i] ? sf::Color(std::min(c.r + 100, 255), std::min(c.g + 100, 255), std::min(c.b + 100, 255)) : c;
+            batch.add(start[i], dirUnit[i], vizLength[i], drawColor);
+        }
+    }
+
+    void drawLabels(CountingRenderTarget& target) {
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (magnitude[i] > 0.05f) target.draw(labels[i]);
+        }
+    }
+
+    std::size_t getMemoryBytes() const {
+        std::size_t bytes = sizeof(*this)
+            + start.capacity() * sizeof(sf::Vector2f) + dirUnit.capacity() * sizeof(sf::Vector2f)
+            + vizLength.capacity() * sizeof(float) + magnitude.capacity() * sizeof(float)
+            + hovered.capacity() + baseColor.capacity() * sizeof(sf::Color)
+            + info.capacity() * sizeof(ArrowInfo) + labels.capacity() * sizeof(BitmapText);
+        for (const ArrowInfo& a : info) bytes += a.name.capacity() + a.formula.capacity() + a.extraDesc.capacity();
+        for (const BitmapText& l : labels) bytes += l.getHeapBytes();
+        return bytes;
+    }
+
+    float getMagnitude(std::size_t i) const { return magnitude[i]; }
+    const std::string& getName(std::size_t i) const { return info[i].name; }
+    const std::string& getFormula(std::size_t i) const { return info[i].formula; }
+};
+
+// Referencia a una flecha concreta de un ForceArrowSet (ids de los indices espaciales)
+struct ArrowRef {
+    ForceArrowSet* set;
+    std::size_t index;
+};
+
+// ----------------- Arbol de widgets -----------------
+// Los widgets se declaran una vez en el UIRoot de su nivel, que los dibuja y reparte los
+// eventos; la memoria es de la arena del nivel, que los destruye con el. Los eventos de
+// raton van al widget con captura (un slider que se arrastra) o al que esta debajo del
+// raton; el texto va solo al widget con foco. Cada grupo guarda la union de los limites de
+// sus hijos, asi la busqueda descarta ramas enteras sin mirar sus widgets.
+class WidgetGroup;
+
+class Widget {
+protected:
+    WidgetGroup* parent;
+    bool commitPending;
+
+    // Pide que commit() se ejecute al cerrar el frame (una vez aunque se pida varias)
+    void requestCommit();
+
+public:
+    Widget() : parent(nullptr), commitPending(false) {}
+    virtual ~Widget() {}
+
+    void setParent(WidgetGroup* p) { parent = p; }
+
+    // Publica los cambios acumulados desde el ultimo commit (p. ej. avisar al callback)
+    virtual void commit() {}
+    void runCommit() {
+        commitPending = false;
+        commit();
+    }
+
+    virtual sf::FloatRect getBounds() const = 0;
+    virtual void draw(CountingRenderTarget& target) = 0;
+    virtual Widget* hitTest(sf::Vector2f p) { return getBounds().contains(p) ? this : nullptr; }
+
+    // Devuelve true si el widget captura el raton hasta que se suelte el boton
+    virtual bool onMousePress(sf::Vector2f, sf::Mouse::Button) { return false; }
+    virtual void onMouseMove(sf::Vector2f) {}
+    virtual void onMouseRelease(sf::Vector2f) {}
+    virtual void onText(sf::Uint32) {}
+
+    virtual bool isFocusable() const { return false; }
+    virtual void setFocus(bool) {}
+
+    virtual const char* typeName() const = 0;
+    virtual std::size_t getMemoryBytes() const = 0;
+    virtual void reportMemory(MemoryReport& report, const std::string& owner) const {
+        report.add("Widgets", owner + ": " + typeName(), getMemoryBytes());
+    }
+};
+
+class WidgetGroup : public Widget {
+private:
+    std::vector<Widget*> children;
+    mutable sf::FloatRect bounds;
+    mutable bool boundsDirty;
+
+public:
+    WidgetGroup() : boundsDirty(true) {}
+
+    // El widget vive en la arena del nivel; el grupo solo lo referencia
+    template <typename T>
+    T* add(T* widget) {
+        widget->setParent(this);
+        children.push_back(widget);
+        invalidate();
+        return widget;
+    }
+
+    void invalidate() {
+        boundsDirty = true;
+        if (parent) parent->invalidate();
+    }
+
+    // Sube la peticion hasta la raiz, que es la que guarda la cola
+    virtual void queueCommit(Widget* w) {
+        if (parent) parent->queueCommit(w);
+        else w->runCommit();
+    }
+
+    sf::FloatRect getBounds() const override {
+        if (boundsDirty) {
+            boundsDirty = false;
+            bounds = sf::FloatRect();
+            for (std::size_t i = 0; i < children.size(); ++i) {
+                sf::FloatRect b = children[i]->getBounds();
+                if (i == 0) { bounds = b; continue; }
+                float right = std::max(bounds.left + bounds.width, b.left + b.width);
+                float bottom = std::max(bounds.top + bounds.height, b.top + b.height);
+                bounds.left = std::min(bounds.left, b.left);
+                bounds.top = std::min(bounds.top, b.top);
+                bounds.width = right - bounds.left;
+                bounds.height = bottom - bounds.top;
+            }
+        }
+        return bounds;
+    }
+
+    void draw(CountingRenderTarget& target) override {
+        for (Widget* w : children) w->draw(target);
+    }
+
+    // El ultimo hijo añadido es el que queda encima
+    Widget* hitTest(sf::Vector2f p) override {
+        if (!getBounds().contains(p)) return nullptr;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (Widget* hit = (*it)->hitTest(p)) return hit;
+        }
+        return nullptr;
+    }
+
+    const char* typeName() const override { return "Grupo"; }
+    std::size_t getMemoryBytes() const override { return sizeof(*this) + children.capacity() * sizeof(Widget*); }
+
+    void reportMemory(MemoryReport& report, const std::string& owner) const override {
+        Widget::reportMemory(report, owner);
+        for (const Widget* w : children) w->reportMemory(report, owner);
+    }
+};
+
+inline void Widget::requestCommit() {
+    if (commitPending) return;
+    commitPending = true;
+    if (parent) parent->queueCommit(this);
+    else runCommit();
+}
+
+class UIRoot : public WidgetGroup {
+private:
+    Widget* focus;
+    Widget* capture;
+    std::vector<Widget*> pendingCommits;
+
+public:
+    UIRoot() : focus(nullptr), capture(nullptr) {}
+
+    void queueCommit(Widget* w) override { pendingCommits.push_back(w); }
+
+    // Una vez por frame (y antes de cualquier evento que no sea un movimiento, para
+    // que un clic vea los valores que el usuario ya tiene en pantalla)
+    void commitChanges() {
+        if (pendingCommits.empty()) return;
+        TRACE_SCOPE("UIRoot::commitChanges");
+        for (std::size_t i = 0; i < pendingCommits.size(); ++i) pendingCommits[i]->runCommit();
+        pendingCommits.clear();
+    }
+
+    void focusWidget(Widget* w) {
+        if (focus && focus != w) focus->setFocus(false);
+        focus = w;
+        if (focus) focus->setFocus(true);
+    }
+
+    // Reparte un evento. Devuelve el widget que recibio la pulsacion, si la hubo.
+    Widget* dispatch(const sf::Event& e, sf::Vector2f mouse) {
+        if (e.type != sf::Event::MouseMoved) commitChanges();
+        switch (e.type) {
+            case sf::Event::MouseButtonPressed: {
+                Widget* hit = hitTest(mouse);
+                if (e.mouseButton.button == sf::Mouse::Left) focusWidget((hit && hit->isFocusable()) ? hit : nullptr);
+                if (hit && hit->onMousePress(mouse, e.mouseButton.button)) capture = hit;
+                return hit;
+            }
+            case sf::Event::MouseMoved:
+                if (capture) capture->onMouseMove(mouse);
+                break;
+            case sf::Event::MouseButtonReleased:
+                if (capture) capture->onMouseRelease(mouse);
+                capture = nullptr;
+                break;
+            case sf::Event::TextEntered:
+                if (focus) focus->onText(e.text.unicode);
+                break;
+            default:
+                break;
+        }
+        return nullptr;
+    }
+
+    const char* typeName() const override { return "UIRoot"; }
+};
+
+class InputBox : public Widget {
+// ... (Contenido de InputBox)
+private:
+    sf::RectangleShape box;
+    BitmapText text;
+    std::string currentString;
+    bool hasFocus;
+    float width, height;
+public:
+    InputBox(float x, float y, float w, float h, BakedFont& font) : width(w), height(h), hasFocus(false), currentString("") {
+        box.setPosition(x, y);
+        box.setSize(sf::Vector2f(w, h));
+        box.setFillColor(sf::Color::White);
+        box.setOutlineColor(sf::Color(100, 100, 100));
+        box.setOutlineThickness(2);
+
+        text.setFont(font);
+        text.setCharacterSize(18);
+        text.setFillColor(sf::Color::Black);
+        text.setPosition(x + 5, y + 5);
+    }
+
+    void onText(sf::Uint32 unicode) override {
+        if (!hasFocus) return;
+        if (unicode == 8) {
+            if (!currentString.empty()) currentString.pop_back();
+        } else if ((unicode >= '0' && unicode <= '9') || unicode == '.') {
+            if (unicode == '.' && currentString.find('.') != std::string::npos) return;
+            
+            if (currentString.length() < 8) currentString += static_cast<char>(unicode);
+        }
+        text.setString(currentString);
+        LatencyTracker::instance().noteChange(LatencyKind::Text);
+    }
+
+    bool isFocusable() const override { return true; }
+
+    void setFocus(bool focus) override {
+        hasFocus = focus;
+        box.setOutlineColor(focus ? sf::Color::Blue : sf::Color(100,100,100));
+    }
+
+    sf::FloatRect getBounds() const override { return box.getGlobalBounds(); }
+
+    float getValue() const {
+        if (currentString.empty()) return 0.0f;
+        try { return std::stof(currentString); } catch (...) { return 0.0f; }
+    }
+
+    void clear() { currentString = ""; text.setString(""); }
+
+    void setString(const char* s) { 
+        currentString = s; 
+        text.setString(currentString); 
+        hasFocus = false; 
+        box.setOutlineColor(sf::Color(100,100,100));
+    }
+
+    const char* typeName() const override { return "InputBox"; }
+    std::size_t getMemoryBytes() const override { return sizeof(*this) + text.getHeapBytes() + currentString.capacity(); }
+
+    void draw(CountingRenderTarget& target) override { target.draw(box); target.draw(text); }
+};
+
+class Button : public Widget {
+// ... (Contenido de Button)
+private:
+    sf::RectangleShape shape;
+    BitmapText text;
+    sf::Color baseColor;
+    std::function<void()> clickCallback;
+public:
+    Button(float x, float y, float w, float h, std::string label, BakedFont& font, sf::Color color) 
+        : baseColor(color) {
+        shape.setPosition(x, y);
+        shape.setSize(sf::Vector2f(w, h));
+        shape.setFillColor(color);
+
+        text.setFont(font);
+        text.setString(label);
+        text.setCharacterSize(16);
+        text.setFillColor(sf::Color::White);
+
+        sf::FloatRect textRect = text.getLocalBounds();
+        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top + textRect.height/2.0f);
+        text.setPosition(x + w/2.0f, y + h/2.0f);
+    }
+    
+    void setFillColor(sf::Color color) { 
+        baseColor = color; 
+        shape.setFillColor(color); 
+    }
+    
+    const sf::Color& getFillColor() const { return baseColor; }
+
+    bool isClicked(sf::Vector2f mousePos) const {
+        return shape.getGlobalBounds().contains(mousePos);
+    }
+
+    void setOnClick(std::function<void()> callback) { clickCallback = callback; }
+
+    bool onMousePress(sf::Vector2f, sf::Mouse::Button button) override {
+        if (button == sf::Mouse::Left && clickCallback) clickCallback();
+        return false;
+    }
+
+    sf::FloatRect getBounds() const override { return shape.getGlobalBounds(); }
+
+    const char* typeName() const override { return "Button"; }
+    std::size_t getMemoryBytes() const override { return sizeof(*this) + text.getHeapBytes(); }
+
+    void draw(CountingRenderTarget& target) override {
+        target.draw(shape);
+        target.draw(text);
+    }
+};
+
+class Slider : public Widget {
+// ... (Contenido de Slider)
+private:
+    sf::RectangleShape bar;
+    sf::CircleShape knob;
+    float minVal, maxVal;
+    float current;
+    float committed; // Ultimo valor comunicado al callback
+    bool dragging;
+    std::function<void(float)> valueChangedCallback; 
+
+public:
+    Slider(float x, float y, float w, float minV, float maxV, float initial = 0.0f, std::function<void(float)> callback = nullptr) 
+        : minVal(minV), maxVal(maxV), current(initial), committed(initial), dragging(false), valueChangedCallback(callback) {
+        
+        bar.setPosition(x, y);
+        bar.setSize(sf::Vector2f(w, 6));
+        bar.setFillColor(sf::Color(180,180,180));
+
+        knob.setRadius(9);
+        knob.setOrigin(9, 9);
+        knob.setFillColor(sf::Color(120,120,255));
+        
+        float t = (initial - minVal) / (maxVal - minVal);
+        float kx = x + std::max(0.f, std::min(t * w, w));
+        knob.setPosition(kx, y + 3);
+
+        if (valueChangedCallback) {
+            valueChangedCallback(current);
+        }
+    }
+
+    void dragTo(sf::Vector2f mouse) {
+        float x = bar.getPosition().x;
+        float w = bar.getSize().x;
+        float newX = std::max(x, std::min(mouse.x, x + w));
+        if (newX != knob.getPosition().x) LatencyTracker::instance().noteChange(LatencyKind::Slider);
+        knob.setPosition(newX, knob.getPosition().y);
+        float t = (newX - x) / w;
+        
+        current = minVal + t * (maxVal - minVal);
+        
+        // El knob se mueve ya; el callback (formateo, fisica) se agrupa al cerrar el frame
+        if (current != committed) requestCommit();
+    }
+
+    void commit() override {
+        if (current == committed) return;
+        committed = current;
+        if (valueChangedCallback) valueChangedCallback(current);
+    }
+
+    // Solo el knob responde al raton; el arrastre sigue aunque el raton salga de la barra
+    Widget* hitTest(sf::Vector2f p) override { return knob.getGlobalBounds().contains(p) ? this : nullptr; }
+
+    bool onMousePress(sf::Vector2f mouse, sf::Mouse::Button) override {
+        dragging = true;
+        dragTo(mouse);
+        return true;
+    }
+    void onMouseMove(sf::Vector2f mouse) override { if (dragging) dragTo(mouse); }
+    void onMouseRelease(sf::Vector2f) override { dragging = false; }
+
+    // Recorrido completo del knob: no cambia al arrastrar
+    sf::FloatRect getBounds() const override {
+        float r = knob.getRadius();
+        return sf::FloatRect(bar.getPosition().x - r, knob.getPosition().y - r, bar.getSize().x + 2 * r, 2 * r);
+    }
+
+    float getValue() const { return current; }
+
+    // El valor actual se recorta al nuevo rango con el siguiente setValue
+    void setRange(float minV, float maxV) {
+        minVal = minV;
+        maxVal = maxV;
+    }
+
+    void setValue(float v) {
+        current = std::max(minVal, std::min(v, maxVal));
+        float t = (current - minVal) / (maxVal - minVal);
+        float x = bar.getPosition().x;
+        float w = bar.getSize().x;
+        float kx = x + t * w;
+        knob.setPosition(kx, knob.getPosition().y);
+        
+        // Cambio programatico: se comunica en el momento
+        committed = current;
+        if (valueChangedCallback) {
+            valueChangedCallback(current);
+        }
+    }
+
+    const char* typeName() const override { return "Slider"; }
+    std::size_t getMemoryBytes() const override { return sizeof(*this); }
+
+    void draw(CountingRenderTarget& target) override {
+        target.draw(bar);
+        target.draw(knob);
+    }
+};
+
+
+// ----------------- Física / Objetos (Clases originales) -----------------
+class Block {
+// ... (Contenido de Block)
+public:
+    sf::RectangleShape shape;
+    ForceArrowSet arrows;
+    float mass;
+    bool isOnSlope;
+
+    // Indices de las flechas en arrows
+    enum SlopeArrow { SLOPE_WEIGHT, SLOPE_NORMAL, SLOPE_PARALLEL, SLOPE_FRICTION, SLOPE_TENSION };
+    enum HangingArrow { HANGING_WEIGHT, HANGING_TENSION };
+
+    Block(bool slope, sf::Color color, BakedFont& font) : arrows(font, slope ? 5 : 2), mass(0), isOnSlope(slope) {
+        shape.setSize(sf::Vector2f(50, 50));
+        shape.setOrigin(25, 25);
+        shape.setFillColor(color);
+        shape.setOutlineColor(sf::Color::Black);
+        shape.setOutlineThickness(2);
+
+        if (isOnSlope) {
+            arrows.add("Peso (W1)", "m1 * g", sf::Color::Red);
+            arrows.add("Normal (N1)", "W1 * cos(\u03B8)", sf::Color::Blue);
+            arrows.add("W Paralela", "W1 * sin(\u03B8)", sf::Color::Magenta);
+            arrows.add("Friccion", "\u03bc * N1", sf::Color::Cyan);
+            arrows.add("Tension", "T", sf::Color::Green);
+        } else {
+            arrows.add("Peso (W2)", "m2 * g", sf::Color::Red);
+            arrows.add("Tension", "T", sf::Color::Green, "Tension cuerda = T");
+        }
+    }
+
+
+    void clearArrows() {
+        arrows.clear(shape.getPosition());
+    }
+
+    void updatePhysics(float m, float thetaDeg, float tensionMag, float frictionMag, bool frictionUpSlope) {
+        TRACE_SCOPE("Block::updatePhysics");
+        mass = m;
+        float thetaRad = toRad(thetaDeg);
+        float w = mass * G;
+        float scale = 2.0f;
+
+        if (isOnSlope) {
+            sf::Vector2f downSlope(std::cos(thetaRad), std::sin(thetaRad));
+            sf::Vector2f upSlope(-std::cos(thetaRad), -std::sin(thetaRad));
+            sf::Vector2f normalDir(-std::sin(thetaRad), std::cos(thetaRad));
+            sf::Vector2f gravityDir(0, 1);
+
+            arrows.update(SLOPE_WEIGHT, shape.getPosition(), gravityDir, w, scale);
+            arrows.update(SLOPE_NORMAL, shape.getPosition(), normalDir, w * std::cos(thetaRad), scale);
+            arrows.update(SLOPE_PARALLEL, shape.getPosition(), downSlope, w * std::sin(thetaRad), scale);
+
+            sf::Vector2f fDir = frictionUpSlope ? upSlope : downSlope;
+            arrows.update(SLOPE_FRICTION, shape.getPosition(), fDir, frictionMag, scale);
+
+            arrows.update(SLOPE_TENSION, shape.getPosition(), upSlope, tensionMag, scale);
+
+        } else {
+            arrows.update(HANGING_WEIGHT, shape.getPosition(), sf::Vector2f(0,1), w, scale);
+            arrows.update(HANGING_TENSION, shape.getPosition(), sf::Vector2f(0,-1), tensionMag, scale);
+        }
+    }
+
+    void draw(CountingRenderTarget& target, ArrowBatch& batch) {
+        target.draw(shape);
+        arrows.draw(batch);
+    }
+
+    void drawLabels(CountingRenderTarget& target) {
+        arrows.drawLabels(target);
+    }
+
+    std::size_t getMemoryBytes() const {
+        return sizeof(*this) - sizeof(arrows) + arrows.getMemoryBytes();
+    }
+
+    void handleHover(sf::Vector2f mouse) {
+        arrows.updateHover(mouse);
+    }
+
+    void handleClick(sf::Vector2f mouse, Tooltip& tooltip) {
+        for (std::size_t i = 0; i < arrows.size(); ++i) arrows.handleClick(i, mouse, tooltip);
+    }
+};
+
+// ----------------- Escalado dinamico de resolucion -----------------
+// Modo opcional (--adaptive-res): la escena se dibuja en un sf::RenderTexture a una fraccion
+// de la resolucion de la ventana, elegida segun el tiempo de trabajo medido de cada frame,
+// y se reescala a la ventana. La UI (texto, botones) se sigue dibujando a resolucion nativa.
+class ResolutionScaler {
+private:
+    sf::RenderTexture sceneTexture;
+    sf::Sprite sceneSprite;
+    bool enabled;
+    float scale;          // Fraccion de la resolucion nativa usada por la escena
+    float avgFrameTime;   // Media movil del tiempo de trabajo (segundos)
+    int framesSinceChange;
+
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float SCALE_STEP = 0.1f;
+    static constexpr float FRAME_BUDGET = 1.f / 60.f;
+    static constexpr int SETTLE_FRAMES = 30; // Frames de espera entre cambios para evitar oscilaciones
+
+public:
+    ResolutionScaler() : enabled(false), scale(MAX_SCALE), avgFrameTime(0.f), framesSinceChange(0) {}
+
+    void setEnabled(bool e) { enabled = e; }
+    bool isEnabled() const { return enabled; }
+    float getScale() const { return enabled ? scale : MAX_SCALE; }
+
+    // Devuelve el destino donde dibujar la escena este frame
+    sf::RenderTarget& begin(sf::RenderTarget& window) {
+        if (!enabled) return window;
+
+        sf::Vector2u size = window.getSize();
+        if (sceneTexture.getSize() != size) {
+            if (!sceneTexture.create(size.x, size.y)) {
+                enabled = false;
+                return window;
+            }
+            sceneTexture.setSmooth(true);
+        }
+
+        // Misma vista logica que la ventana, pero solo sobre la esquina escalada de la textura
+        sf::View view = window.getView();
+        view.setViewport(sf::FloatRect(0.f, 0.f, scale, scale));
+        sceneTexture.setView(view);
+        return sceneTexture;
+    }
+
+    void reportMemory(MemoryReport& report) const {
+        sf::Vector2u size = sceneTexture.getSize();
+        report.add("Vertices y texturas", "Escena a resolucion reducida", static_cast<std::size_t>(size.x) * size.y * 4);
+    }
+
+    // Copia la escena escalada a la ventana
+    void end(CountingRenderTarget& window) {
+        if (!enabled) return;
+        sceneTexture.display();
+
+        sf::Vector2u size = sceneTexture.getSize();
+        int w = static_cast<int>(size.x * scale);
+        int h = static_cast<int>(size.y * scale);
+        const sf::View& view = window.getTarget().getView();
+
+        sceneSprite.setTexture(sceneTexture.getTexture());
+        sceneSprite.setTextureRect(sf::IntRect(0, 0, w, h));
+        sceneSprite.setScale(view.getSize().x / w, view.getSize().y / h);
+        sceneSprite.setPosition(view.getCenter() - view.getSize() / 2.f);
+        window.draw(sceneSprite);
+    }
+
+    // Ajusta la escala con el tiempo de trabajo del frame (sin contar la espera del limitador de FPS)
+    void adapt(float workTime) {
+        if (!enabled) return;
+        avgFrameTime = (avgFrameTime == 0.f) ? workTime : avgFrameTime * 0.9f + workTime * 0.1f;
+        if (++framesSinceChange < SETTLE_FRAMES) return;
+
+        if (avgFrameTime > FRAME_BUDGET * 0.9f && scale > MIN_SCALE) {
+            scale = std::max(MIN_SCALE, scale - SCALE_STEP);
+            framesSinceChange = 0;
+        } else if (avgFrameTime < FRAME_BUDGET * 0.6f && scale < MAX_SCALE) {
+            scale = std::min(MAX_SCALE, scale + SCALE_STEP);
+            framesSinceChange = 0;
+        }
+    }
+};
+
+// ----------------- Catalogo de niveles (niveles.cfg) -----------------
+// Angulos, intentos, rangos de sliders y del sube y baja y coordenadas de la UI de cada
+// nivel. Se lee en una sola pasada a structs planos: lineas "clave = v1 v2 ..." dentro de
+// secciones [nivel1] / [nivel2], con comentarios '#'. Lo que no aparezca conserva el valor
+// por defecto (el del juego original). En ventana el archivo se vigila (inotify en Linux,
+// fecha de modificacion en el resto) y se recarga sin reiniciar: el nivel activo conserva
+// su puzzle y aplica los valores nuevos al reiniciarlo; la UI nueva se ve al volver a entrar.
+const int MAX_CATALOGUE_ANGLES = 16;
+
+// Los grupos de valores de una misma clave van en arrays, en el orden del archivo
+struct InclineLevelConfig {
+    int angles[MAX_CATALOGUE_ANGLES];
+    int angleCount;
+    int attempts;
+    float mass[3];      // min, max, inicial (kg)
+    float mu[3];        // min, max, inicial
+    float inputX;
+    float inputY[3];    // m1, m2, mu
+    float inputSize[2]; // ancho, alto
+    float slider[2];    // desplazamiento bajo la entrada, ancho
+    float buttons[2];   // x, y
+    float messageY;
+};
+
+struct SeesawLevelConfig {
+    int weightP1[2];     // min, max (kg)
+    int distP1[3];       // min, max, paso (cm)
+    int distP2[2];       // min, max (cm)
+    float board[2];      // ancho, alto
+    float pivot[2];      // x, y
+    float input[4];      // x, y, ancho, alto
+    float buttonSize[2]; // ancho, alto
+    float data[3];       // x, y, interlineado
+};
+
+class LevelCatalogue {
+private:
+    // Una entrada por clave: destino en el struct y numero de valores (variable si countOut)
+    struct Field {
+        const char* section;
+        const char* key;
+        bool isInt;
+        void* dest;
+        int count;
+        int* countOut;
+    };
+
+    static bool matches(const char* begin, const char* end, const char* word) {
+        std::size_t n = std::strlen(word);
+        return static_cast<std::size_t>(end - begin) == n && std::memcmp(begin, word, n) == 0;
+    }
+
+    bool validate(std::string& error) const {
+        const InclineLevelConfig& a = incline;
+        const SeesawLevelConfig& b = seesaw;
+        if (a.angleCount < 1) error = "[nivel1] angulos necesita al menos un valor";
+        else if (a.attempts < 1) error = "[nivel1] intentos debe ser mayor que 0";
+        else if (a.mass[0] >= a.mass[1] || a.mu[0] >= a.mu[1]) error = "[nivel1] rango de slider vacio";
+        else if (a.mass[2] < a.mass[0] || a.mass[2] > a.mass[1] || a.mu[2] < a.mu[0] || a.mu[2] > a.mu[1]) error = "[nivel1] valor inicial fuera del rango del slider";
+        else if (b.weightP1[0] <= 0) error = "[nivel2] peso_p1 debe ser mayor que 0";
+        else if (b.weightP1[0] > b.weightP1[1] || b.distP2[0] > b.distP2[1] || b.distP2[0] <= 0) error = "[nivel2] rango vacio";
+        else if (b.distP1[2] <= 0 || b.distP1[1] / b.distP1[2] < b.distP1[0] / b.distP1[2]) error = "[nivel2] distancia_p1 sin multiplos del paso";
+        else if (b.distP1[0] < b.distP1[2]) error = "[nivel2] distancia_p1 debe empezar en un multiplo del paso mayor que 0";
+        for (int i = 0; error.empty() && i < a.angleCount; ++i) {
+            if (a.angles[i] <= 0 || a.angles[i] >= 90) error = "[nivel1] angulo " + std::to_string(a.angles[i]) + " fuera de (0, 90)";
+        }
+        return error.empty();
+    }
+
+public:
+    InclineLevelConfig incline;
+    SeesawLevelConfig seesaw;
+
+    LevelCatalogue() : incline(), seesaw() {
+        const int angles[] = {45, 30, 60, 16, 37, 53};
+        incline.angleCount = 6;
+        for (int i = 0; i < incline.angleCount; ++i) incline.angles[i] = angles[i];
+        incline.attempts = 3;
+        incline.mass[0] = 0.5f; incline.mass[1] = 100.f; incline.mass[2] = 5.f;
+        incline.mu[0] = 0.f; incline.mu[1] = 1.f; incline.mu[2] = 0.2f;
+        incline.inputX = 50.f;
+        incline.inputY[0] = 50.f; incline.inputY[1] = 140.f; incline.inputY[2] = 230.f;
+        incline.inputSize[0] = 100.f; incline.inputSize[1] = 30.f;
+        incline.slider[0] = 40.f; incline.slider[1] = 200.f;
+        incline.buttons[0] = 280.f; incline.buttons[1] = 50.f;
+        incline.messageY = 100.f;
+
+        seesaw.weightP1[0] = 50; seesaw.weightP1[1] = 120;
+        seesaw.distP1[0] = 20; seesaw.distP1[1] = 100; seesaw.distP1[2] = 20;
+        seesaw.distP2[0] = 10; seesaw.distP2[1] = 100;
+        seesaw.board[0] = 600.f; seesaw.board[1] = 20.f;
+        seesaw.pivot[0] = 500.f; seesaw.pivot[1] = 550.f;
+        seesaw.input[0] = 50.f; seesaw.input[1] = 50.f; seesaw.input[2] = 120.f; seesaw.input[3] = 30.f;
+        seesaw.buttonSize[0] = 180.f; seesaw.buttonSize[1] = 40.f;
+        seesaw.data[0] = 700.f; seesaw.data[1] = 50.f; seesaw.data[2] = 25.f;
+    }
+
+    // Analiza [begin, end) sobre una copia; si hay un error el catalogo no cambia
+    bool parse(const char* begin, const char* end, std::string& error) {
+        LevelCatalogue next = *this;
+        InclineLevelConfig& a = next.incline;
+        SeesawLevelConfig& b = next.seesaw;
+        const Field fields[] = {
+            {"nivel1", "angulos", true, a.angles, MAX_CATALOGUE_ANGLES, &a.angleCount},
+            {"nivel1", "intentos", true, &a.attempts, 1, nullptr},
+            {"nivel1", "masa", false, a.mass, 3, nullptr},
+            {"nivel1", "friccion", false, a.mu, 3, nullptr},
+            {"nivel1", "entrada_x", false, &a.inputX, 1, nullptr},
+            {"nivel1", "entrada_y", false, a.inputY, 3, nullptr},
+            {"nivel1", "entrada_tam", false, a.inputSize, 2, nullptr},
+            {"nivel1", "slider", false, a.slider, 2, nullptr},
+            {"nivel1", "botones", false, a.buttons, 2, nullptr},
+            {"nivel1", "mensaje_y", false, &a.messageY, 1, nullptr},
+            {"nivel2", "peso_p1", true, b.weightP1, 2, nullptr},
+            {"nivel2", "distancia_p1", true, b.distP1, 3, nullptr},
+            {"nivel2", "distancia_p2", true, b.distP2, 2, nullptr},
+            {"nivel2", "tabla", false, b.board, 2, nullptr},
+            {"nivel2", "pivote", false, b.pivot, 2, nullptr},
+            {"nivel2", "entrada", false, b.input, 4, nullptr},
+            {"nivel2", "botones_tam", false, b.buttonSize, 2, nullptr},
+            {"nivel2", "datos", false, b.data, 3, nullptr},
+        };
+
+        const char* sectionBegin = nullptr;
+        const char* sectionEnd = nullptr;
+        int line = 0;
+        const char* p = begin;
+        while (p < end) {
+            ++line;
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!eol) eol = end;
+            const char* q = p;
+            p = eol + 1;
+
+            while (q < eol && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+            if (q == eol || *q == '#') continue;
+
+            if (*q == '[') {
+                sectionBegin = ++q;
+                while (q < eol && *q != ']') ++q;
+                sectionEnd = q;
+                continue;
+            }
+
+            const char* keyBegin = q;
+            while (q < eol && *q != '=' && *q != ' ' && *q != '\t') ++q;
+            const char* keyEnd = q;
+            while (q < eol && (*q == ' ' || *q == '\t' || *q == '=')) ++q;
+
+            const Field* field = nullptr;
+            for (const Field& f : fields) {
+                if (sectionBegin && matches(sectionBegin, sectionEnd, f.section) && matches(keyBegin, keyEnd, f.key)) { field = &f; break; }
+            }
+            if (!field) {
+                error = "linea " + std::to_string(line) + ": clave desconocida '" + std::string(keyBegin, keyEnd) + "'";
+                return false;
+            }
+
+            int n = 0;
+            while (q < eol && *q != '#' && *q != '\r') {
+                if (*q == ' ' || *q == '\t') { ++q; continue; }
+                if (n == field->count) {
+                    error = "linea " + std::to_string(line) + ": demasiados valores";
+                    return false;
+                }
+                std::from_chars_result r = field->isInt ? std::from_chars(q, eol, static_cast<int*>(field->dest)[n])
+                                                        : std::from_chars(q, eol, static_cast<float*>(field->dest)[n]);
+                if (r.ec != std::errc()) {
+                    error = "linea " + std::to_string(line) + ": numero no valido";
+                    return false;
+                }
+                q = r.ptr;
+                ++n;
+            }
+            if (field->countOut) *field->countOut = n;
+            else if (n != field->count) {
+                error = "linea " + std::to_string(line) + ": " + field->key + " necesita " + std::to_string(field->count) + " valores";
+                return false;
+            }
+        }
+
+        if (!next.validate(error)) return false;
+        *this = next;
+        return true;
+    }
+
+    bool loadFile(const std::string& path, std::string& error) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "no se pudo abrir";
+            return false;
+        }
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return parse(data.data(), data.data() + data.size(), error);
+    }
+};
+
+// Avisa cuando cambia un archivo. inotify sobre el directorio (los editores suelen guardar
+// con un rename); fuera de Linux se compara la fecha de modificacion cada medio segundo.
+class FileWatcher {
+private:
+    std::string dir;
+    std::string name;
+#ifdef __linux__
+    int fd;
+#else
+    long long lastStamp;
+    int callsUntilCheck;
+
+    long long stamp() const {
+        struct stat st;
+        std::string path = dir + "/" + name;
+        return (stat(path.c_str(), &st) == 0) ? static_cast<long long>(st.st_mtime) : -1;
+    }
+#endif
+
+public:
+#ifdef __linux__
+    FileWatcher() : fd(-1) {}
+    ~FileWatcher() { if (fd >= 0) close(fd); }
+#else
+    FileWatcher() : lastStamp(-1), callsUntilCheck(0) {}
+#endif
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watch(const std::string& path) {
+        std::size_t slash = path.find_last_of("/\\");
+        dir = (slash == std::string::npos) ? "." : path.substr(0, slash);
+        name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return false;
+        if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(fd);
+            fd = -1;
+            return false;
+        }
+        return true;
+#else
+        lastStamp = stamp();
+        return true;
+#endif
+    }
+
+    // No bloquea; llamar una vez por frame
+    bool changed() {
+#ifdef __linux__
+        if (fd < 0) return false;
+        bool hit = false;
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t len;
+        while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + len; ) {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                if (ev->len > 0 && name == ev->name) hit = true;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        return hit;
+#else
+        if (dir.empty() || --callsUntilCheck > 0) return false;
+        callsUntilCheck = 30;
+        long long now = stamp();
+        if (now == lastStamp) return false;
+        lastStamp = now;
+        return now >= 0;
+#endif
+    }
+};
+
+const char* const LEVEL_CATALOGUE_PATH = "niveles.cfg";
+
+// Si falta o tiene errores se quedan los valores por defecto
+LevelCatalogue loadLevelCatalogue(const std::string& path) {
+    LevelCatalogue catalogue;
+    std::string error;
+    if (!catalogue.loadFile(path, error))
+        std::cerr << "Aviso: " << path << ": " << error << "; se usan los valores por defecto" << std::endl;
+    return catalogue;
+}
+
+// ----------------- Partida guardada (partida.sav) -----------------
+// Progreso (niveles ganados y visitas), el puzzle en curso de cada nivel y sus ultimos
+// intentos, en un archivo binario de tamaño fijo con version y checksum. Cuando cambia el
+// estado, el hilo que hace update copia una instantanea (~1 KB) a una cola sin locks y un
+// hilo aparte la escribe en un temporal, hace fsync y lo renombra encima del anterior: un
+// corte deja la partida vieja o la nueva, nunca una mezcla. Al arrancar el archivo se mapea
+// en memoria y se valida en su sitio, sin analizar nada. Formato: los structs tal cual en
+// memoria (little-endian, sin relleno); una version distinta se descarta.
+const char* const SAVE_PATH = "partida.sav";
+const sf::Uint32 SAVE_MAGIC = 0x56415346; // "FSAV"
+const sf::Uint16 SAVE_VERSION = 2;
+const int SAVE_MAX_LEVELS = 4;
+const int SAVE_MAX_ATTEMPTS = 16;
+const int SAVE_POLL_MS = 20; // Espera del hilo de guardado entre comprobaciones de la cola
+
+struct SavedAttempt {
+    float input[3]; // Nivel 1: m1, m2, mu; Nivel 2: peso de P2
+    sf::Uint32 won;
+};
+
+struct SavedLevel {
+    sf::Uint8 id;           // GameState; 0 (menu) = hueco libre
+    sf::Uint8 won;          // Ganado alguna vez
+    sf::Uint8 hasPuzzle;    // Hay un puzzle en curso que restaurar
+    sf::Uint8 attemptCount;
+    sf::Uint8 puzzleWon;        // El puzzle en curso esta resuelto
+    sf::Uint8 simulationActive; // Hay un intento evaluado en pantalla (fuerzas, balanza)
+    sf::Uint16 reserved;
+    sf::Uint32 visits;
+    sf::Int32 puzzle[4];    // Nivel 1: angulo, intentos restantes; Nivel 2: peso P1, distancia P1, distancia P2
+    float inputs[3];        // Entradas en pantalla, exactas. Nivel 1: m1, m2, mu; Nivel 2: peso de P2
+    SavedAttempt attempts[SAVE_MAX_ATTEMPTS]; // Del mas antiguo al mas reciente
+};
+
+struct SaveFile {
+    sf::Uint32 magic;
+    sf::Uint16 version;
+    sf::Uint16 size;     // sizeof(SaveFile): detecta archivos truncados o de otra compilacion
+    sf::Uint32 sequence; // Numero de guardado
+    sf::Uint32 checksum; // FNV-1a de levels
+    SavedLevel levels[SAVE_MAX_LEVELS];
+};
+
+// El archivo son estos bytes tal cual: un cambio de disposicion debe llevar otra SAVE_VERSION
+static_assert(std::is_trivially_copyable<SaveFile>::value, "SaveFile se escribe y se mapea como bytes");
+static_assert(sizeof(SaveFile) == 1200, "La disposicion de SaveFile cambio: subir SAVE_VERSION y este tamaño");
+
+sf::Uint32 saveChecksum(const SaveFile& file) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(file.levels);
+    sf::Uint32 h = 2166136261u;
+    for (std::size_t i = 0; i < sizeof(file.levels); ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// data apunta al archivo completo (mapeado); el puntero devuelto es valido mientras lo sea data
+const SaveFile* checkSaveFile(const void* data, std::size_t size, std::string& error) {
+    if (size < 8) {
+        error = "no es una partida guardada";
+        return nullptr;
+    }
+    const SaveFile* file = static_cast<const SaveFile*>(data); // Hasta comprobar el tamaño solo se leen magic y version
+    if (file->magic != SAVE_MAGIC) error = "no es una partida guardada";
+    else if (file->version != SAVE_VERSION) error = "version " + std::to_string(file->version) + " no soportada";
+    else if (size != sizeof(SaveFile) || file->size != sizeof(SaveFile)) error = "tamaño inesperado";
+    else if (file->checksum != saveChecksum(*file)) error = "checksum incorrecto";
+    return error.empty() ? file : nullptr;
+}
+
+// Archivo de solo lectura mapeado en memoria
+class MappedFile {
+private:
+    const void* data;
+    std::size_t size;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+
+public:
+#ifdef _WIN32
+    MappedFile() : data(nullptr), size(0), mapping(nullptr) {}
+#else
+    MappedFile() : data(nullptr), size(0) {}
+#endif
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false si no existe, esta vacio o no se puede mapear
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data) size = static_cast<std::size_t>(fileSize.QuadPart);
+        }
+        CloseHandle(file); // El mapeo mantiene el archivo abierto
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = p;
+                size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+#endif
+        if (!data) close();
+        return data != nullptr;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        if (data) munmap(const_cast<void*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const void* getData() const { return data; }
+    std::size_t getSize() const { return size; }
+};
+
+// Escritura atomica: temporal + fsync + rename. Se llama desde el hilo de guardado.
+bool writeSaveFile(const std::string& path, const SaveFile& file) {
+    std::string tmp = path + ".tmp";
+#ifdef _WIN32
+    HANDLE h = CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(h, &file, sizeof(file), &written, nullptr) && written == sizeof(file) && FlushFileBuffers(h);
+    CloseHandle(h);
+    return ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const char* p = reinterpret_cast<const char*>(&file);
+    std::size_t left = sizeof(file);
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n <= 0) {
+            ::close(fd);
+            return false;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    bool ok = fsync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) return false;
+
+    // fsync del directorio para que el rename tambien sobreviva a un corte
+    std::size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash);
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+#endif
+}
+
+// Cola de un productor y un consumidor con capacidad fija (N potencia de 2)
+template <typename T, unsigned int N>
+class SpscQueue {
+private:
+    T items[N];
+    std::atomic<unsigned int> head; // Siguiente a leer, solo lo avanza el consumidor
+    std::atomic<unsigned int> tail; // Siguiente a escribir, solo lo avanza el productor
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    bool push(const T& item) {
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        items[t % N] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        unsigned int h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h % N];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
+
+// Hilo de guardado. submit() nunca bloquea: con la cola llena devuelve false y el llamador
+// lo reintenta en el frame siguiente. De varias instantaneas pendientes solo se escribe la ultima.
+class SaveWriter {
+private:
+    std::string path;
+    SpscQueue<SaveFile, 4> queue;
+    std::atomic<bool> running;
+    sf::Uint32 sequence; // Solo lo toca el productor
+    sf::Thread thread;
+
+    void run() {
+        SaveFile latest;
+        for (;;) {
+            bool stopping = !running.load(std::memory_order_acquire); // Antes de vaciar: no se pierde lo ultimo
+            bool pending = false;
+            while (queue.pop(latest)) pending = true;
+            if (pending && !writeSaveFile(path, latest))
+                std::cerr << "Aviso: no se pudo guardar la partida en " << path << std::endl;
+            if (stopping) return;
+            sf::sleep(sf::milliseconds(SAVE_POLL_MS));
+        }
+    }
+
+public:
+    SaveWriter() : running(false), sequence(0), thread(&SaveWriter::run, this) {}
+    ~SaveWriter() { stop(); }
+
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+
+    void start(const std::string& savePath) {
+        if (running.load(std::memory_order_relaxed)) return;
+        path = savePath;
+        running.store(true, std::memory_order_release);
+        thread.launch();
+    }
+
+    // Escribe lo pendiente y termina el hilo
+    void stop() {
+        running.store(false, std::memory_order_release);
+        thread.wait();
+    }
+
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Antes de start(): continua la numeracion de la partida cargada
+    void setSequence(sf::Uint32 seq) { sequence = seq; }
+
+    // Sella (version, checksum) y encola; false si la cola esta llena
+    bool submit(SaveFile& file) {
+        file.magic = SAVE_MAGIC;
+        file.version = SAVE_VERSION;
+        file.size = sizeof(SaveFile);
+        file.sequence = sequence + 1;
+        file.checksum = saveChecksum(file);
+        if (!queue.push(file)) return false;
+        ++sequence;
+        return true;
+    }
+};
+
+// ----------------- Clase Base para Simuladores -----------------
+class SimulationBase {
+protected:
+    BakedFont& font;
+    BitmapText msgLabel;
+    LevelArena arena;      // Widgets, bloques, flechas y tooltip del nivel
+    UIRoot ui;             // Arbol de widgets del nivel (la memoria es de arena)
+    Button* btnMenu;
+    bool menuRequested;
+    ArrowBatch arrowBatch; // Cuerpos de todas las flechas del nivel, un draw call por frame
+
+    // Para la partida guardada: ultimos intentos del puzzle en curso y contador de cambios
+    SavedAttempt history[SAVE_MAX_ATTEMPTS];
+    int historyCount;
+    sf::Uint32 stateRevision;
+
+public:
+    SimulationBase(BakedFont& f) : font(f), arena(LEVEL_ARENA_BYTES), menuRequested(false), historyCount(0), stateRevision(0) {
+        msgLabel.setFont(font);
+        msgLabel.setCharacterSize(20);
+        msgLabel.setFillColor(sf::Color::Black);
+
+        btnMenu = ui.add(arena.make<Button>(800.f, 20.f, 180.f, 40.f, "Volver al Menu", font, sf::Color(100, 100, 100)));
+        btnMenu->setOnClick([this]() { menuRequested = true; });
+    }
+    virtual ~SimulationBase() {}
+    
+    virtual int handleEvents(const sf::Event& event, sf::Vector2f mousePos) = 0;
+    virtual void update(float dt) = 0;
+    virtual void drawScene(CountingRenderTarget& target) = 0; // Geometria, puede ir a resolucion reducida
+    virtual void drawUI(CountingRenderTarget& target) = 0;    // Texto y widgets, siempre a resolucion nativa
+    virtual void reportMemory(MemoryReport& report) const = 0;
+    virtual bool getIsWon() const = 0;
+    virtual void saveState(SavedLevel& out) const = 0;  // Puzzle en curso e intentos
+    virtual void restoreState(const SavedLevel& in) = 0;
+
+    // Cambia con cada puzzle nuevo o intento; Game guarda cuando cambia
+    sf::Uint32 getStateRevision() const { return stateRevision; }
+
+    void draw(CountingRenderTarget& target, ResolutionScaler& scaler) {
+        TRACE_SCOPE("SimulationBase::draw");
+        if (target.isRecording()) { // Sin sf::RenderTarget no hay escalado: resolucion nativa
+            drawScene(target);
+            drawUI(target);
+            return;
+        }
+        CountingRenderTarget scene(scaler.begin(target.getTarget()), target.getStats());
+        drawScene(scene);
+        scaler.end(target);
+        drawUI(target);
+    }
+    
+    void commitUI() { ui.commitChanges(); }
+
+protected:
+    // Puzzle nuevo: se olvidan los intentos
+    void clearHistory() {
+        historyCount = 0;
+        ++stateRevision;
+    }
+
+    // Con el historial lleno se descarta el intento mas antiguo
+    void recordAttempt(float a, float b, float c, bool won) {
+        if (historyCount == SAVE_MAX_ATTEMPTS) {
+            std::memmove(history, history + 1, (SAVE_MAX_ATTEMPTS - 1) * sizeof(SavedAttempt));
+            --historyCount;
+        }
+        history[historyCount++] = SavedAttempt{{a, b, c}, won ? 1u : 0u};
+        ++stateRevision;
+    }
+
+    void saveHistory(SavedLevel& out) const {
+        out.attemptCount = static_cast<sf::Uint8>(historyCount);
+        std::memcpy(out.attempts, history, historyCount * sizeof(SavedAttempt));
+    }
+
+    void restoreHistory(const SavedLevel& in) {
+        historyCount = std::min<int>(in.attemptCount, SAVE_MAX_ATTEMPTS);
+        std::memcpy(history, in.attempts, historyCount * sizeof(SavedAttempt));
+        ++stateRevision;
+    }
+
+    // true una sola vez tras pulsar "Volver al Menu"
+    bool takeMenuRequest() {
+        bool requested = menuRequested;
+        menuRequested = false;
+        return requested;
+    }
+
+    // Parte comun: objeto del nivel, arbol de widgets, mensaje y lote de flechas
+    void reportBaseMemory(MemoryReport& report, const std::string& level, std::size_t objectSize) const {
+        report.add("Widgets", level + ": objeto del nivel", objectSize);
+        ui.reportMemory(report, level);
+        arena.reportMemory(report, level);
+        report.add("Widgets", level + ": textos", msgLabel.getHeapBytes());
+        arrowBatch.reportMemory(report, level);
+    }
+};
+
+// ----------------- Simulador Nivel 1 (Clase original, adaptada para la estructura base) -----------------
+class Simulator : public SimulationBase {
+// ... (Contenido de Simulator)
+private:
+    InputBox* inputM1;
+    InputBox* inputM2;
+    InputBox* inputMu;
+    Slider* sliderM1;
+    Slider* sliderM2;
+    Slider* sliderMu;
+    Button* btnTest;
+    Button* btnReset;
+    Tooltip* tooltip;
+    BitmapText labels[8];
+
+    sf::ConvexShape ramp;
+    sf::CircleShape pulley;
+    sf::VertexArray rope;
+    BitmapText angTxt;
+
+    Block* blockYellow;
+    Block* blockOrange;
+
+    const InclineLevelConfig& config; // Del catalogo; puede cambiar con una recarga
+
+    int currentAngle;
+    int attempts;
+    bool simulationActive;
+    std::string message;
+    float MU; 
+    bool isWon;
+
+    // Hit testing de las flechas (cambian con la fisica); los widgets van por el arbol de ui
+    HitGrid arrowIndex;
+    std::vector<ArrowRef> indexedArrows; // Id en arrowIndex = posicion
+    std::vector<ArrowRef> hoveredArrows;
+    bool arrowIndexDirty;
+
+    void rebuildHitIndex() {
+        if (arrowIndexDirty) {
+            arrowIndex.clear();
+            indexedArrows.clear();
+            for (Block* b : {blockYellow, blockOrange}) {
+                for (std::size_t i = 0; i < b->arrows.size(); ++i) {
+                    if (!b->arrows.isHittable(i)) continue;
+                    arrowIndex.add(static_cast<int>(indexedArrows.size()), b->arrows.getHitShape(i));
+                    indexedArrows.push_back(ArrowRef{&b->arrows, i});
+                }
+            }
+            arrowIndex.build();
+            arrowIndexDirty = false;
+        }
+    }
+
+    void updateArrowHover(sf::Vector2f mousePos) {
+        for (const ArrowRef& a : hoveredArrows) a.set->setHovered(a.index, false);
+        hoveredArrows.clear();
+        arrowIndex.forEachAt(mousePos, [&](int id) {
+            const ArrowRef& a = indexedArrows[id];
+            a.set->setHovered(a.index, true);
+            hoveredArrows.push_back(a);
+        });
+    }
+
+public:
+    Simulator(BakedFont& font, const InclineLevelConfig& cfg)
+        : SimulationBase(font), rope(sf::LineStrip), config(cfg), MU(0.2f), isWon(false), arrowIndexDirty(true) {
+        setupUI();
+        resetGame();
+    }
+
+    bool getIsWon() const override { return isWon; }
+
+    void reportMemory(MemoryReport& report) const override {
+        const std::string level = "Nivel 1";
+        reportBaseMemory(report, level, sizeof(*this));
+        report.add("Widgets", level + ": Tooltip", tooltip->getMemoryBytes());
+        report.add("Widgets", level + ": bloques y flechas", blockYellow->getMemoryBytes() + blockOrange->getMemoryBytes(), 2);
+        std::size_t texts = angTxt.getHeapBytes() + message.capacity();
+        for (const BitmapText& t : labels) texts += t.getHeapBytes();
+        report.add("Widgets", level + ": textos", texts, 9);
+        report.add("Vertices y texturas", level + ": cuerda y rampa", rope.getVertexCount() * sizeof(sf::Vertex) + ramp.getPointCount() * sizeof(sf::Vector2f));
+    }
+
+    void updateInputFromSlider(InputBox* input, float value, int precision) {
+        TextBuffer buf;
+        buf.appendFixed(value, precision);
+        input->setString(buf.c_str());
+    }
+
+    // Con precision fija si no pierde nada; si no, el valor exacto tecleado
+    static void setInputExact(InputBox* input, float value, int precision) {
+        TextBuffer buf;
+        buf.appendFixed(value, precision);
+        if (std::strtof(buf.c_str(), nullptr) != value) {
+            buf.clear();
+            buf.appendShortest(value);
+        }
+        input->clear();
+        input->setString(buf.c_str());
+    }
+
+    void saveState(SavedLevel& out) const override {
+        out.hasPuzzle = 1;
+        out.puzzleWon = isWon ? 1 : 0;
+        out.simulationActive = simulationActive ? 1 : 0;
+        out.puzzle[0] = currentAngle;
+        out.puzzle[1] = attempts;
+        out.inputs[0] = inputM1->getValue();
+        out.inputs[1] = inputM2->getValue();
+        out.inputs[2] = inputMu->getValue();
+        saveHistory(out);
+    }
+
+    // Se restaura el estado tal cual, sin repetir la prueba: no gasta intentos ni anota otro.
+    // Un puzzle que el catalogo actual ya no admite se ignora y queda el nuevo.
+    void restoreState(const SavedLevel& in) override {
+        if (!std::count(config.angles, config.angles + config.angleCount, in.puzzle[0])) return;
+        if (in.puzzle[1] < 0 || in.puzzle[1] > config.attempts) return;
+        currentAngle = in.puzzle[0];
+        attempts = in.puzzle[1];
+        setupGeometry();
+
+        sliderM1->setValue(in.inputs[0]); setInputExact(inputM1, in.inputs[0], 2);
+        sliderM2->setValue(in.inputs[1]); setInputExact(inputM2, in.inputs[1], 2);
+        sliderMu->setValue(in.inputs[2]); setInputExact(inputMu, in.inputs[2], 3);
+        restoreHistory(in);
+
+        isWon = in.puzzleWon != 0;
+        simulationActive = in.simulationActive != 0 && historyCount > 0;
+        if (simulationActive) {
+            // Las fuerzas en pantalla son las de la ultima prueba, con sus valores exactos
+            const SavedAttempt& last = history[historyCount - 1];
+            MU = last.input[2];
+            applyForces(last.input[0], last.input[1], isWon);
+            showResult();
+        } else {
+            isWon = false;
+            message = "Intentos restantes: " + std::to_string(attempts);
+            msgLabel.setString(message);
+            msgLabel.setFillColor(sf::Color::Black);
+        }
+    }
+
+
+    void setupUI() {
+        float input_x = config.inputX;
+        float input_y1 = config.inputY[0];
+        float input_y2 = config.inputY[1];
+        float input_y3 = config.inputY[2];
+        float input_w = config.inputSize[0];
+        float input_h = config.inputSize[1];
+        float slider_offset = config.slider[0]; 
+        float slider_w = config.slider[1];
+        
+        // Panel de masas y friccion (entradas + sliders) y fila de botones
+        WidgetGroup* massPanel = ui.add(arena.make<WidgetGroup>());
+        inputM1 = massPanel->add(arena.make<InputBox>(input_x, input_y1, input_w, input_h, font));
+        inputM2 = massPanel->add(arena.make<InputBox>(input_x, input_y2, input_w, input_h, font));
+        inputMu = massPanel->add(arena.make<InputBox>(input_x, input_y3, input_w, input_h, font));
+
+        sliderM1 = massPanel->add(arena.make<Slider>(input_x, input_y1 + slider_offset, slider_w, config.mass[0], config.mass[1], config.mass[2], 
+            [this](float v){ this->updateInputFromSlider(this->inputM1, v, 2); })); 
+        
+        sliderM2 = massPanel->add(arena.make<Slider>(input_x, input_y2 + slider_offset, slider_w, config.mass[0], config.mass[1], config.mass[2], 
+            [this](float v){ this->updateInputFromSlider(this->inputM2, v, 2); })); 
+            
+        sliderMu = massPanel->add(arena.make<Slider>(input_x, input_y3 + slider_offset, slider_w, config.mu[0], config.mu[1], config.mu[2], 
+            [this](float v){ this->updateInputFromSlider(this->inputMu, v, 3); })); 
+
+        float button_x = config.buttons[0];
+        float button_y = config.buttons[1];
+        float message_y = config.messageY;
+        
+        WidgetGroup* buttonRow = ui.add(arena.make<WidgetGroup>());
+        btnTest = buttonRow->add(arena.make<Button>(button_x, button_y, 100, 30, "Probar", font, sf::Color(0,150,0)));
+        btnReset = buttonRow->add(arena.make<Button>(button_x + 120, button_y, 100, 30, "Reiniciar", font, sf::Color(200,100,0)));
+        btnTest->setOnClick([this]() { if (attempts > 0 && !isWon) calculatePhysics(); });
+        btnReset->setOnClick([this]() { resetGame(); });
+
+        tooltip = arena.make<Tooltip>(font);
+
+        labels[0].setFont(font); labels[0].setString("Masa 1 (kg) (Amarillo):"); labels[0].setPosition(input_x, input_y1 - 25); labels[0].setCharacterSize(14); labels[0].setFillColor(sf::Color::Black);
+        labels[1].setFont(font); labels[1].setString("Masa 2 (kg) (Naranja):"); labels[1].setPosition(input_x, input_y2 - 25); labels[1].setCharacterSize(14); labels[1].setFillColor(sf::Color::Black);
+        labels[3].setFont(font); labels[3].setString("Coef. de friccion:"); labels[3].setPosition(input_x, input_y2 + 70); labels[3].setCharacterSize(14); labels[3].setFillColor(sf::Color::Black);
+        
+        msgLabel.setPosition(button_x, message_y);
+
+        angTxt.setFont(font);
+        angTxt.setFillColor(sf::Color::Black);
+        angTxt.setCharacterSize(16);
+
+
+        blockYellow = arena.make<Block>(true, sf::Color::Yellow, font);
+        blockOrange = arena.make<Block>(false, sf::Color(255,165,0), font);
+    }
+
+    void resetGame() {
+        currentAngle = config.angles[std::rand() % config.angleCount];
+        attempts = config.attempts;
+        simulationActive = false;
+        isWon = false;
+        message = "Intentos restantes: " + std::to_string(attempts);
+        msgLabel.setString(message);
+        msgLabel.setFillColor(sf::Color::Black);
+
+        // Rangos del catalogo (pueden haber cambiado con una recarga)
+        sliderM1->setRange(config.mass[0], config.mass[1]);
+        sliderM2->setRange(config.mass[0], config.mass[1]);
+        sliderMu->setRange(config.mu[0], config.mu[1]);
+        sliderM1->setValue(config.mass[2]);
+        sliderM2->setValue(config.mass[2]);
+        sliderMu->setValue(config.mu[2]);
+
+        TextBuffer mass;
+        mass.appendFixed(config.mass[2], 2);
+        inputM1->clear(); inputM1->setString(mass.c_str());
+        inputM2->clear(); inputM2->setString(mass.c_str());
+        inputMu->clear(); inputMu->setString("0.00");
+        MU = config.mu[2];
+        clearHistory();
+
+        blockYellow->clearArrows();
+        blockOrange->clearArrows();
+        tooltip->hide();
+        arrowIndexDirty = true;
+
+        setupGeometry();
+    }
+    
+    // ... (El resto de la lógica de Simulator es la misma)
+    void setupGeometry() {
+        float px = 400.0f;
+        float py = 180.0f; 
+        float base = 400.0f;
+        float theta = toRad(currentAngle);
+        float h = base * std::tan(theta);
+
+        if (h > 350) { h = 350; base = h / std::tan(theta); }
+
+        sf::Vector2f A(px, py);
+        sf::Vector2f B(px, py + h);
+        sf::Vector2f C(px + base, py + h);
+
+        float a = 30.0f;
+        if (currentAngle >= 60) a = 60.0f;
+        sf::Vector2f A2(px, py + a);
+        sf::Vector2f B2(px, py + a + h);
+        sf::Vector2f C2(px + base, py + a + h);
+
+        ramp.setPointCount(3);
+        ramp.setPoint(0, A2);
+        ramp.setPoint(1, B2);
+        ramp.setPoint(2, C2);
+        ramp.setFillColor(sf::Color(150,150,150));
+
+        angTxt.setString(std::to_string(currentAngle) + "\u00B0"); 
+        angTxt.setPosition(C2.x - 60, C2.y - 30);
+
+        sf::Vector2f slopeDir = C - A;
+        float len = std::sqrt(slopeDir.x*slopeDir.x + slopeDir.y*slopeDir.y);
+        slopeDir /= len;
+
+        float distOnSlope = 0.45f * len;
+        sf::Vector2f blockYellowPos = A + slopeDir * distOnSlope;
+
+        blockYellow->shape.setPosition(blockYellowPos);
+        blockYellow->shape.setRotation(currentAngle);
+
+        sf::Vector2f pulleyPos = A - slopeDir * 20.0f;
+        pulley.setRadius(15);
+        pulley.setOrigin(15,15);
+        pulley.setPosition(pulleyPos);
+        pulley.setFillColor(sf::Color(50,50,50));
+
+        sf::Vector2f blockOrangePos(pulleyPos.x, pulleyPos.y + 120.0f);
+        blockOrange->shape.setPosition(blockOrangePos);
+
+        rope.clear();
+        rope.setPrimitiveType(sf::LineStrip);
+        rope.resize(3);
+        rope[0].position = blockYellowPos;
+        rope[1].position = pulleyPos;
+        rope[2].position = blockOrangePos;
+        rope[0].color = rope[1].color = rope[2].color = sf::Color::Black;
+    }
+
+    void calculatePhysics() {
+        TRACE_SCOPE("Simulator::calculatePhysics");
+        float m1 = inputM1->getValue();
+        float m2 = inputM2->getValue();
+        float inMu = inputMu->getValue();
+
+        MU = inMu; 
+
+        if (m1 <= 0 || m2 <= 0) {
+            msgLabel.setString("Introduce masas validas (>0)");
+            msgLabel.setFillColor(sf::Color::Red);
+            return;
+        }
+
+        float thetaRad = toRad(currentAngle);
+        float W1 = m1 * G;
+        float W2 = m2 * G;
+        float W1_para = W1 * std::sin(thetaRad);
+        float N1 = W1 * std::cos(thetaRad);
+        float Ff_max = MU * N1;
+
+        float netForce = W1_para - W2;
+        
+        if (std::abs(netForce) < Ff_max + EPSILON) {
+            simulationActive = true;
+            isWon = true; 
+        } else {
+            attempts--;
+            simulationActive = true;
+            isWon = false;
+        }
+        recordAttempt(m1, m2, MU, isWon);
+
+        applyForces(m1, m2, isWon);
+        showResult();
+    }
+
+    // Fuerzas de los bloques para unas masas y el MU actual: en equilibrio el rozamiento
+    // compensa la fuerza neta; si no, es el maximo
+    void applyForces(float m1, float m2, bool balanced) {
+        float thetaRad = toRad(currentAngle);
+        float W1 = m1 * G;
+        float W2 = m2 * G;
+        float W1_para = W1 * std::sin(thetaRad);
+        float N1 = W1 * std::cos(thetaRad);
+        float Ff_max = MU * N1;
+        float Tension = W2;
+
+        float netForce = W1_para - W2;
+        bool frictionUp = (netForce > 0); 
+        float actualFriction = balanced ? std::abs(netForce) : Ff_max;
+
+        blockYellow->updatePhysics(m1, currentAngle, Tension, actualFriction, frictionUp);
+        blockOrange->updatePhysics(m2, 0, Tension, 0, false);
+        arrowIndexDirty = true;
+    }
+
+    // Mensaje tras una prueba (o al restaurarla)
+    void showResult() {
+        if (isWon) {
+            message = "EQUILIBRIO! GANASTE.";
+            msgLabel.setFillColor(sf::Color::Green);
+        } else if (attempts > 0) {
+            message = "No equilibrado. Intentos: " + std::to_string(attempts);
+            msgLabel.setFillColor(sf::Color::Red);
+        } else {
+            message = "Juego terminado. Fallaste.";
+            msgLabel.setFillColor(sf::Color::Red);
+        }
+        msgLabel.setString(message);
+    }
+    
+    int handleEvents(const sf::Event& event, sf::Vector2f mousePos) override {
+        ui.dispatch(event, mousePos);
+        if (takeMenuRequest()) return 0;
+
+        if (event.type == sf::Event::MouseButtonPressed) {
+            if (event.mouseButton.button == sf::Mouse::Left) {
+                tooltip->hide();
+                if (simulationActive) {
+                    for (const ArrowRef& a : hoveredArrows) a.set->handleClick(a.index, mousePos, *tooltip);
+                }
+            } else {
+                tooltip->hide();
+            }
+        }
+        
+        if (simulationActive) {
+            rebuildHitIndex();
+            updateArrowHover(mousePos);
+        }
+        
+        return 1; 
+    }
+
+    void update(float dt) override {} 
+    
+    void drawScene(CountingRenderTarget& target) override {
+        TRACE_SCOPE("Simulator::drawScene");
+        target.clear(sf::Color(240,240,240));
+
+        target.draw(ramp);
+        if (rope.getVertexCount() > 0) target.draw(rope);
+        target.draw(pulley);
+
+        arrowBatch.clear();
+        blockYellow->draw(target, arrowBatch);
+        blockOrange->draw(target, arrowBatch);
+        arrowBatch.draw(target);
+    }
+
+    void drawUI(CountingRenderTarget& target) override {
+        TRACE_SCOPE("Simulator::drawUI");
+        target.draw(angTxt);
+
+        blockYellow->drawLabels(target);
+        blockOrange->drawLabels(target);
+
+        ui.draw(target);
+
+        for (int i = 0; i < 6; ++i) target.draw(labels[i]);
+        target.draw(msgLabel); 
+
+        tooltip->draw(target);
+    }
+};
+
+// ----------------- Simulador Nivel 2 (NUEVA CLASE: Sube y Baja - MODIFICADA) -----------------
+
+class SeesawSimulator : public SimulationBase {
+private:
+    // Geometría
+    sf::RectangleShape board; 
+    sf::CircleShape pivot;    
+    sf::RectangleShape base;   
+    
+    // Figuras/Personas
+    sf::CircleShape person1;
+    sf::CircleShape person2;
+
+    // UI
+    InputBox* inputWeightP2;
+    Button* btnCalculate;
+    Button* btnNewGame;
+    Tooltip* tooltip;
+    
+    // Flechas de fuerza (momento)
+    ForceArrowSet* forces; // Momentos de P1 y P2, en los indices HIT_P1 y HIT_P2
+
+    // Textos de cotas y panel de datos: se rehacen solo cuando cambia el estado, no en cada frame
+    BitmapText labelInput;
+    BitmapText distTxt1, distTxt2;
+    BitmapText dataLabels[6];
+    BitmapText dataValues[6];
+
+    // Parámetros de juego
+    float weightP1, weightP2_input;
+    int distP1, distP2; // <-- Ahora enteros (cm)
+    float momentP1, momentP2;
+    float correctWeightP2; // <-- Respuesta precalculada
+    bool isWon;
+    
+    // Del catalogo; puede cambiar con una recarga (los rangos se leen en cada resetGame)
+    const SeesawLevelConfig& config;
+
+    // Constantes Visuales: fijas mientras viva el nivel
+    const float BOARD_WIDTH;
+    const float BOARD_HEIGHT;
+    const float PIVOT_X; 
+    const float PIVOT_Y; 
+
+    // Hit testing de las flechas (cambian con updateVisualState); los widgets van por el arbol de ui
+    enum ArrowHit { HIT_P1, HIT_P2 };
+    HitGrid arrowIndex;
+    bool arrowIndexDirty;
+
+    void rebuildHitIndex() {
+        if (arrowIndexDirty) {
+            arrowIndex.clear();
+            for (int id : {HIT_P1, HIT_P2}) {
+                if (forces->isHittable(id)) arrowIndex.add(id, forces->getHitShape(id));
+            }
+            arrowIndex.build();
+            arrowIndexDirty = false;
+        }
+    }
+
+    void updateArrowHover(sf::Vector2f mousePos) {
+        forces->clearHover();
+        arrowIndex.forEachAt(mousePos, [&](int id) { forces->setHovered(id, true); });
+    }
+
+public:
+    SeesawSimulator(BakedFont& font, const SeesawLevelConfig& cfg)
+        : SimulationBase(font), isWon(false), config(cfg), BOARD_WIDTH(cfg.board[0]), BOARD_HEIGHT(cfg.board[1]),
+          PIVOT_X(cfg.pivot[0]), PIVOT_Y(cfg.pivot[1]), arrowIndexDirty(true) {
+        setupUI();
+        setupGeometry();
+        resetGame();
+    }
+    
+    bool getIsWon() const override { return isWon; }
+
+    void saveState(SavedLevel& out) const override {
+        out.hasPuzzle = 1;
+        out.puzzleWon = isWon ? 1 : 0;
+        out.simulationActive = historyCount > 0 ? 1 : 0;
+        out.puzzle[0] = static_cast<sf::Int32>(weightP1);
+        out.puzzle[1] = distP1;
+        out.puzzle[2] = distP2;
+        out.inputs[0] = inputWeightP2->getValue();
+        saveHistory(out);
+    }
+
+    // Se restaura el estado tal cual, sin repetir la comprobacion: no anota otro intento.
+    // Un puzzle que el catalogo actual ya no admite se ignora y queda el nuevo.
+    void restoreState(const SavedLevel& in) override {
+        if (in.puzzle[0] < config.weightP1[0] || in.puzzle[0] > config.weightP1[1]) return;
+        int step = config.distP1[2]; // Mismos multiplos que randomMultipleInt
+        if (in.puzzle[1] % step != 0 || in.puzzle[1] < config.distP1[0] / step * step || in.puzzle[1] > config.distP1[1] / step * step) return;
+        bool equalArms = in.puzzle[2] == in.puzzle[1]; // Puzzle de reserva de resetGame
+        if (!equalArms && (in.puzzle[2] < config.distP2[0] || in.puzzle[2] > config.distP2[1])) return;
+        weightP1 = static_cast<float>(in.puzzle[0]);
+        distP1 = in.puzzle[1];
+        distP2 = in.puzzle[2];
+        correctWeightP2 = (weightP1 * distP1) / (float)distP2;
+
+        inputWeightP2->clear();
+        if (in.inputs[0] > 0.f) {
+            TextBuffer weight;
+            weight.appendShortest(in.inputs[0]);
+            inputWeightP2->setString(weight.c_str());
+        }
+        restoreHistory(in);
+
+        isWon = in.puzzleWon != 0;
+        if (in.simulationActive && historyCount > 0) {
+            // La balanza muestra el ultimo peso comprobado, con su valor exacto
+            weightP2_input = history[historyCount - 1].input[0];
+            momentP1 = weightP1 * distP1;
+            momentP2 = weightP2_input * distP2;
+            showResult();
+        } else {
+            isWon = false;
+        }
+        updateVisualState();
+    }
+
+    void reportMemory(MemoryReport& report) const override {
+        const std::string level = "Nivel 2";
+        reportBaseMemory(report, level, sizeof(*this));
+        report.add("Widgets", level + ": Tooltip", tooltip->getMemoryBytes());
+        report.add("Widgets", level + ": flechas", forces->getMemoryBytes(), 2);
+        std::size_t texts = labelInput.getHeapBytes() + distTxt1.getHeapBytes() + distTxt2.getHeapBytes();
+        for (int i = 0; i < 6; ++i) texts += dataLabels[i].getHeapBytes() + dataValues[i].getHeapBytes();
+        report.add("Widgets", level + ": textos", texts, 15);
+    }
+
+    // Generar un número entero aleatorio en el rango [min, max]
+    int randomInt(int min, int max) {
         return min + (rand() % (max - min + 1));
     }
     
-    // Generar un múltiplo de step en el rango [min, max] (para P1)
-    int randomMultipleInt(int min, int max, int step) {
-        int minStep = (min / step);
-        int maxStep = (max / step);
-        int randomStep = minStep + (rand() % (maxStep - minStep + 1));
-        return randomStep * step;
+    // Generar un múltiplo de step en el rango [min, max] (para P1)
+    int randomMultipleInt(int min, int max, int step) {
+        int minStep = (min / step);
+        int maxStep = (max / step);
+        int randomStep = minStep + (rand() % (maxStep - minStep + 1));
+        return randomStep * step;
+    }
+
+    /**
+     * @brief Comprueba si un float tiene un máximo de 4 decimales significativos.
+     * @details Se usa para regenerar los valores si la respuesta es demasiado compleja.
+     * @param value El valor a comprobar (Peso P2 correcto).
+     * @return true si el valor puede ser representado con 4 decimales o menos.
+     */
+    bool hasMaxFourDecimals(float value) {
+        // Redondea el valor a 4 decimales
+        float rounded = std::round(value * 10000.f) / 10000.f;
+        // Comprueba si la diferencia es insignificante (menor a un error de 5ta decimal)
+        return std::abs(value - rounded) < 0.000001f;
+    }
+
+
+    void setupUI() {
+        float input_x = config.input[0];
+        float input_y = config.input[1];
+        float input_w = config.input[2];
+        float input_h = config.input[3];
+        float button_w = config.buttonSize[0];
+        float button_h = config.buttonSize[1];
+        
+        inputWeightP2 = ui.add(arena.make<InputBox>(input_x, input_y + 30, input_w, input_h, font));
+
+        btnCalculate = ui.add(arena.make<Button>(input_x, input_y + 80, button_w, button_h, "Calcular Equilibrio", font, sf::Color(0,100,180)));
+        btnNewGame = ui.add(arena.make<Button>(input_x, input_y + 130, button_w, button_h, "Nuevo Juego", font, sf::Color(200,100,0)));
+        btnCalculate->setOnClick([this]() { calculateEquilibrium(); });
+        btnNewGame->setOnClick([this]() { resetGame(); });
+        
+        labelInput.setFont(font); labelInput.setString("Peso P2 (kg):"); labelInput.setPosition(input_x, input_y); labelInput.setCharacterSize(18); labelInput.setFillColor(sf::Color::Black);
+
+        distTxt1.setFont(font); distTxt1.setCharacterSize(14); distTxt1.setFillColor(sf::Color::Blue);
+        distTxt2.setFont(font); distTxt2.setCharacterSize(14); distTxt2.setFillColor(sf::Color::Red);
+
+        float data_x = config.data[0];
+        float data_y = config.data[1];
+        float line_spacing = config.data[2];
+        const int rows[6] = {0, 1, 2, 4, 5, 6};
+        const char* names[6] = {"P1 Peso:", "P1 Distancia:", "P1 Momento:", "P2 Peso:", "P2 Distancia:", "P2 Momento:"};
+        const sf::Color colors[6] = {sf::Color::Yellow, sf::Color::Blue, sf::Color::Red, sf::Color::Cyan, sf::Color::Red, sf::Color::Blue};
+        for (int i = 0; i < 6; ++i) {
+            float y = data_y + rows[i] * line_spacing;
+            dataLabels[i].setFont(font); dataLabels[i].setCharacterSize(16); dataLabels[i].setFillColor(sf::Color::Black);
+            dataLabels[i].setString(names[i]); dataLabels[i].setPosition(data_x, y);
+            dataValues[i].setFont(font); dataValues[i].setCharacterSize(16); dataValues[i].setFillColor(colors[i]);
+            dataValues[i].setPosition(data_x + 150, y);
+        }
+        
+        msgLabel.setPosition(input_x, input_y + 190);
+        msgLabel.setCharacterSize(22);
+        
+        tooltip = arena.make<Tooltip>(font);
+        
+        forces = arena.make<ForceArrowSet>(font, 2);
+        forces->add("Momento P1", "Peso * Distancia", sf::Color::Red, "Seesaw");
+        forces->add("Momento P2", "Peso * Distancia", sf::Color::Blue, "Seesaw");
+    }
+
+    void setupGeometry() {
+        base.setSize(sf::Vector2f(20.f, 100.f));
+        base.setOrigin(10.f, 0.f);
+        base.setPosition(PIVOT_X, PIVOT_Y);
+        base.setFillColor(sf::Color(100, 100, 100));
+        
+        pivot.setRadius(15.f);
+        pivot.setOrigin(15.f, 15.f);
+        pivot.setPosition(PIVOT_X, PIVOT_Y);
+        pivot.setFillColor(sf::Color::Black);
+
+        board.setSize(sf::Vector2f(BOARD_WIDTH, BOARD_HEIGHT));
+        board.setOrigin(BOARD_WIDTH / 2.f, BOARD_HEIGHT / 2.f);
+        board.setPosition(PIVOT_X, PIVOT_Y - BOARD_HEIGHT / 2.f);
+        board.setFillColor(sf::Color(139, 69, 19)); 
+        
+        person1.setRadius(20.f); person1.setOrigin(20.f, 20.f); person1.setFillColor(sf::Color::Yellow); person1.setOutlineColor(sf::Color::Black); person1.setOutlineThickness(2.f);
+        person2.setRadius(20.f); person2.setOrigin(20.f, 20.f); person2.setFillColor(sf::Color::Cyan); person2.setOutlineColor(sf::Color::Black); person2.setOutlineThickness(2.f);
+    }
+    
+    void resetGame() {
+        // Lógica de generación con comprobación de decimales en la respuesta. Algunos rangos del
+        // catalogo no tienen ninguna combinacion valida: se limita el numero de intentos.
+        const int MAX_PUZZLE_TRIES = 1000;
+        int tries = 0;
+        do {
+            // P1: Peso en [min, max] kg (por defecto [50, 120])
+            weightP1 = randomInt(config.weightP1[0], config.weightP1[1]);
+            // P1: Distancia múltiplo del paso en [min, max] cm (por defecto de 20 en [20, 100])
+            distP1 = randomMultipleInt(config.distP1[0], config.distP1[1], config.distP1[2]);
+            
+            // P2: Distancia en [min, max] cm (por defecto [10, 100])
+            distP2 = randomInt(config.distP2[0], config.distP2[1]);
+
+            // Cálculo de la respuesta correcta: Peso₂ = (Peso₁ * Distancia₁) / Distancia₂
+            correctWeightP2 = (weightP1 * distP1) / (float)distP2;
+            
+        } while (!hasMaxFourDecimals(correctWeightP2) && ++tries < MAX_PUZZLE_TRIES);
+
+        // Sin combinacion valida: brazos iguales, la respuesta es el peso de P1
+        if (!hasMaxFourDecimals(correctWeightP2)) {
+            distP2 = distP1;
+            correctWeightP2 = weightP1;
+        }
+
+        // UI y estado
+        inputWeightP2->clear();
+        clearHistory();
+        isWon = false;
+        weightP2_input = 0.f;
+        momentP1 = 0.f;
+        momentP2 = 0.f;
+        
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2) << correctWeightP2;
+
+        //msgLabel.setString("Ingresa el peso de P2 para equilibrar.\nRespuesta requerida: " + ss.str() + " kg"); // Mostrar la respuesta para propósitos de prueba
+        msgLabel.setFillColor(sf::Color::Black);
+        
+        forces->update(HIT_P1, sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+        forces->update(HIT_P2, sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+
+        updateVisualState();
+    }
+    
+    void calculateEquilibrium() {
+        weightP2_input = inputWeightP2->getValue();
+        
+        if (weightP2_input <= 0.01f) {
+            msgLabel.setString("¡Ingresa un peso valido para P2!");
+            msgLabel.setFillColor(sf::Color::Red);
+            updateVisualState();
+            return;
+        }
+        
+        momentP1 = weightP1 * distP1;
+        momentP2 = weightP2_input * distP2;
+        
+        // Criterio de Equilibrio: Peso de usuario vs. Peso correcto (precalculado)
+        // Usamos la tolerancia para aceptar respuestas cercanas, incluyendo redondeo.
+        float inputRatio = weightP2_input / correctWeightP2;
+        
+        // ¡EQUILIBRIO! o DESEQUILIBRIO
+        isWon = std::abs(inputRatio - 1.0f) <= (EPSILON / correctWeightP2); // Normalizar la tolerancia
+        recordAttempt(weightP2_input, 0.f, 0.f, isWon);
+        showResult();
+
+        updateVisualState();
+    }
+
+    // Mensaje tras una comprobacion (o al restaurarla)
+    void showResult() {
+        if (isWon) {
+            msgLabel.setString("¡EQUILIBRIO LOGRADO! GANASTE.");
+            msgLabel.setFillColor(sf::Color::Green);
+        } else {
+            msgLabel.setString("DESEQUILIBRIO: Ingresa otro peso.");
+            msgLabel.setFillColor(sf::Color::Red);
+        }
+    }
+
+    void updateVisualState() {
+        float max_angle = 15.f; 
+        float max_moment = 120.f * 100.f; 
+        float angle = 0.f;
+        
+        if (!isWon) {
+            float moment_diff = momentP1 - momentP2; 
+            angle = moment_diff / max_moment * max_angle;
+            angle = std::max(-max_angle, std::min(max_angle, angle));
+        }
+        
+        board.setRotation(angle);
+        
+        float rad_angle = toRad(angle);
+        float y_offset = PIVOT_Y - BOARD_HEIGHT / 2.f;
+        
+        // P1 (izquierda, Distancia = distP1)
+        float p1_dist_from_center = -(float)distP1 * BOARD_WIDTH / 200.f; 
+        float p1_x = PIVOT_X + p1_dist_from_center * std::cos(rad_angle);
+        float p1_y = y_offset + p1_dist_from_center * std::sin(rad_angle);
+        
+        // P2 (derecha, Distancia = distP2)
+        float p2_dist_from_center = (float)distP2 * BOARD_WIDTH / 200.f; 
+        float p2_x = PIVOT_X + p2_dist_from_center * std::cos(rad_angle);
+        float p2_y = y_offset + p2_dist_from_center * std::sin(rad_angle);
+
+        person1.setPosition(p1_x, p1_y - person1.getRadius());
+        person2.setPosition(p2_x, p2_y - person2.getRadius());
+        
+        if (weightP2_input > 0.01f) {
+            float scale_factor = 0.01f; 
+            
+            forces->update(HIT_P1, person1.getPosition() + sf::Vector2f(0, 20), sf::Vector2f(0, 1), weightP1 * G, scale_factor);
+            forces->update(HIT_P2, person2.getPosition() + sf::Vector2f(0, 20), sf::Vector2f(0, 1), weightP2_input * G, scale_factor);
+        } else {
+            forces->update(HIT_P1, sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+            forces->update(HIT_P2, sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+        }
+        arrowIndexDirty = true;
+
+        updateDataTexts();
+    }
+
+    void updateDataTexts() {
+        float y_dist = PIVOT_Y + 50.f;
+
+        TextBuffer buf;
+        buf.appendInt(distP1).append(" cm");
+        distTxt1.setString(buf);
+        distTxt1.setPosition(PIVOT_X - (float)distP1 * BOARD_WIDTH / 400.f - 20, y_dist + 5);
+
+        buf.clear();
+        buf.appendInt(distP2).append(" cm");
+        distTxt2.setString(buf);
+        distTxt2.setPosition(PIVOT_X + (float)distP2 * BOARD_WIDTH / 400.f - 20, y_dist + 5);
+
+        buf.clear(); buf.appendQuantity(weightP1, 0, "kg");
+        dataValues[0].setString(buf);
+        buf.clear(); buf.appendInt(distP1).append(" cm");
+        dataValues[1].setString(buf);
+        buf.clear(); buf.appendQuantity(momentP1, 2, "N*cm");
+        dataValues[2].setString(buf);
+        buf.clear(); buf.appendQuantity(weightP2_input, 2, "kg (Input)");
+        dataValues[3].setString(buf);
+        buf.clear(); buf.appendInt(distP2).append(" cm");
+        dataValues[4].setString(buf);
+        buf.clear(); buf.appendQuantity(momentP2, 2, "N*cm");
+        dataValues[5].setString(buf);
+    }
+    
+    // Lineas de cota de las distancias (parte de la escena)
+    void drawGuides(CountingRenderTarget& target) {
+        float x_left_p1 = PIVOT_X - (float)distP1 * BOARD_WIDTH / 200.f;
+        float x_right_p2 = PIVOT_X + (float)distP2 * BOARD_WIDTH / 200.f;
+        float y_dist = PIVOT_Y + 50.f;
+
+        drawDashedLine(target, PIVOT_X, PIVOT_Y, x_left_p1, y_dist, sf::Color::Black);
+        drawDashedLine(target, PIVOT_X, y_dist, x_left_p1, y_dist, sf::Color::Blue);
+        drawDashedLine(target, PIVOT_X, PIVOT_Y, x_right_p2, y_dist, sf::Color::Black);
+        drawDashedLine(target, PIVOT_X, y_dist, x_right_p2, y_dist, sf::Color::Red);
+    }
+
+    // Textos de cotas y panel de datos (parte de la UI)
+    void drawData(CountingRenderTarget& target) {
+        TRACE_SCOPE("SeesawSimulator::drawData");
+        target.draw(distTxt1);
+        target.draw(distTxt2);
+        for (int i = 0; i < 6; ++i) {
+            target.draw(dataLabels[i]);
+            target.draw(dataValues[i]);
+        }
+    }
+    
+    void drawDashedLine(CountingRenderTarget& target, float x1, float y1, float x2, float y2, sf::Color color) {
+        TRACE_SCOPE("SeesawSimulator::drawDashedLine");
+        const float segment_length = 5.f;
+        const float gap_length = 3.f;
+
+        float dx = x2 - x1;
+        float dy = y2 - y1;
+        float length = std::sqrt(dx*dx + dy*dy);
+        
+        if (length < segment_length) return;
+
+        sf::Vector2f dir_unit(dx / length, dy / length);
+
+        float current_pos = 0;
+        while (current_pos < length) {
+            float line_start = current_pos;
+            float line_end = std::min(current_pos + segment_length, length);
+
+            sf::Vertex line[] = {
+                sf::Vertex(sf::Vector2f(x1 + dir_unit.x * line_start, y1 + dir_unit.y * line_start), color),
+                sf::Vertex(sf::Vector2f(x1 + dir_unit.x * line_end, y1 + dir_unit.y * line_end), color)
+            };
+            target.draw(line, 2, sf::Lines);
+
+            current_pos += segment_length + gap_length;
+        }
+    }
+    
+    int handleEvents(const sf::Event& event, sf::Vector2f mousePos) override {
+        ui.dispatch(event, mousePos);
+        if (takeMenuRequest()) return 0; 
+
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            tooltip->hide();
+            
+            if (momentP1 > 0 || momentP2 > 0) {
+                rebuildHitIndex();
+                updateArrowHover(mousePos);
+                if (forces->getIsHovered(HIT_P1)) {
+                    tooltip->show(forces->getName(HIT_P1), forces->getFormula(HIT_P1), momentP1, mousePos, "Seesaw");
+                } else if (forces->getIsHovered(HIT_P2)) {
+                    tooltip->show(forces->getName(HIT_P2), forces->getFormula(HIT_P2), momentP2, mousePos, "Seesaw");
+                }
+            }
+        }
+        
+        if (momentP1 > 0 || momentP2 > 0) {
+            rebuildHitIndex();
+            updateArrowHover(mousePos);
+        }
+
+        return 2; 
     }
 
-    /**
-     * @brief Comprueba si un float tiene un máximo de 4 decimales significativos.
-     * @details Se usa para regenerar los valores si la respuesta es demasiado compleja.
-     * @param value El valor a comprobar (Peso P2 correcto).
-     * @return true si el valor puede ser representado con 4 decimales o menos.
-     */
-    bool hasMaxFourDecimals(float value) {
-        // Redondea el valor a 4 decimales
-        float rounded = std::round(value * 10000.f) / 10000.f;
-        // Comprueba si la diferencia es insignificante (menor a un error de 5ta decimal)
-        return std::abs(value - rounded) < 0.000001f;
+    void update(float dt) override {
+        // Nada
+    }
+
+    void drawScene(CountingRenderTarget& target) override {
+        TRACE_SCOPE("SeesawSimulator::drawScene");
+        target.clear(sf::Color::White);
+
+        drawGuides(target); // Guias primero para que no tapen los elementos centrales
+
+        target.draw(base);
+        target.draw(board);
+        target.draw(pivot);
+        
+        target.draw(person1);
+        target.draw(person2);
+        
+        arrowBatch.clear();
+        forces->draw(arrowBatch);
+        arrowBatch.draw(target);
+    }
+
+    void drawUI(CountingRenderTarget& target) override {
+        TRACE_SCOPE("SeesawSimulator::drawUI");
+        ui.draw(target);
+        
+        target.draw(labelInput);
+        target.draw(msgLabel);
+        
+        drawData(target);
+
+        forces->drawLabels(target);
+
+        tooltip->draw(target);
+    }
+};
+
+// ----------------- Registro de niveles -----------------
+// Cada nivel se registra con una fabrica y se construye la primera vez que se entra en el.
+// Con eviccion activada (--evict-levels SEGUNDOS) un nivel que lleva ese tiempo sin usarse
+// se destruye; su progreso (ganado, visitas) y su puzzle en curso quedan en un registro
+// pequeño y al volver se construye de nuevo con el mismo puzzle. El arranque solo paga el
+// menu. Un puzzle cargado de la partida guardada espera aqui igual hasta que se construye.
+enum class GameState { Menu, Level1, Level2 };
+
+struct LevelProgress {
+    bool won;
+    unsigned int visits;
+};
+
+class LevelRegistry {
+private:
+    struct Entry {
+        GameState id;
+        std::string title; // Texto del boton del menu
+        std::function<std::unique_ptr<SimulationBase>(BakedFont&)> factory;
+        std::unique_ptr<SimulationBase> instance;
+        LevelProgress progress;
+        float idleSeconds;
+        bool stale; // Construido con un catalogo anterior: se destruye al salir
+        SavedLevel saved; // Puzzle de la partida guardada, pendiente si saved.hasPuzzle
+    };
+
+    BakedFont& font;
+    std::vector<Entry> entries;
+    float evictAfter; // <= 0: nunca
+
+    Entry* find(GameState id) {
+        for (Entry& e : entries) if (e.id == id) return &e;
+        return nullptr;
+    }
+    const Entry* find(GameState id) const {
+        for (const Entry& e : entries) if (e.id == id) return &e;
+        return nullptr;
+    }
+
+    // Destruye la instancia guardando antes su puzzle e intentos, que se restauran al volver
+    void evict(Entry& e) {
+        if (e.instance->getIsWon()) e.progress.won = true;
+        e.instance->saveState(e.saved);
+        e.instance.reset();
+        e.stale = false;
+    }
+
+public:
+    LevelRegistry(BakedFont& f) : font(f), evictAfter(0.f) {}
+    LevelRegistry(const LevelRegistry&) = delete;
+    LevelRegistry& operator=(const LevelRegistry&) = delete;
+
+    void add(GameState id, const std::string& title, std::function<std::unique_ptr<SimulationBase>(BakedFont&)> factory) {
+        entries.push_back(Entry{id, title, factory, nullptr, LevelProgress{false, 0}, 0.f, false, SavedLevel()});
+    }
+
+    void setEvictAfter(float seconds) { evictAfter = seconds; }
+
+    std::size_t size() const { return entries.size(); }
+    GameState getId(std::size_t i) const { return entries[i].id; }
+    const std::string& getTitle(std::size_t i) const { return entries[i].title; }
+
+    // Construye el nivel si hace falta
+    SimulationBase* enter(GameState id) {
+        Entry* e = find(id);
+        if (!e) return nullptr;
+        if (!e->instance) {
+            TRACE_SCOPE("LevelRegistry::construct");
+            e->instance = e->factory(font);
+            if (e->saved.hasPuzzle) {
+                e->instance->restoreState(e->saved);
+                e->saved.hasPuzzle = 0;
+            }
+        }
+        e->idleSeconds = 0.f;
+        ++e->progress.visits;
+        return e->instance.get();
+    }
+
+    // nullptr si no esta construido
+    SimulationBase* get(GameState id) {
+        Entry* e = find(id);
+        return e ? e->instance.get() : nullptr;
+    }
+
+    // Al salir de un nivel
+    void leave(GameState id) {
+        Entry* e = find(id);
+        if (!e || !e->instance) return;
+        if (e->instance->getIsWon()) e->progress.won = true;
+        if (e->stale) evict(*e);
+    }
+
+    // Tras recargar el catalogo: los niveles inactivos se destruyen ya y el activo al salir.
+    // Sus puzzles se conservan; restoreState descarta los que el catalogo nuevo ya no admite.
+    void invalidate(GameState active) {
+        for (Entry& e : entries) {
+            if (!e.instance) continue;
+            if (e.id == active) e.stale = true;
+            else evict(e);
+        }
+    }
+
+    const LevelProgress* getProgress(GameState id) const {
+        const Entry* e = find(id);
+        return e ? &e->progress : nullptr;
+    }
+
+    bool isWon(GameState id) const {
+        const LevelProgress* p = getProgress(id);
+        return p && p->won;
+    }
+
+    // Progreso de todos los niveles y puzzle de los construidos (o aun pendientes)
+    void snapshot(SaveFile& file) const {
+        std::memset(&file, 0, sizeof(file));
+        for (std::size_t i = 0; i < entries.size() && i < SAVE_MAX_LEVELS; ++i) {
+            const Entry& e = entries[i];
+            SavedLevel& out = file.levels[i];
+            if (e.instance) e.instance->saveState(out);
+            else if (e.saved.hasPuzzle) out = e.saved;
+            out.id = static_cast<sf::Uint8>(e.id);
+            out.won = (e.progress.won || (e.instance && e.instance->getIsWon())) ? 1 : 0;
+            out.visits = e.progress.visits;
+        }
+    }
+
+    // Antes de entrar en ningun nivel; los ids que ya no existen se ignoran
+    void restore(const SaveFile& file) {
+        for (const SavedLevel& in : file.levels) {
+            Entry* e = in.id ? find(static_cast<GameState>(in.id)) : nullptr;
+            if (!e) continue;
+            e->progress.won = in.won != 0;
+            e->progress.visits = in.visits;
+            e->saved = in;
+        }
+    }
+
+    // Cuenta el tiempo sin usar de los niveles construidos que no estan activos
+    void tick(float dt, GameState active) {
+        if (evictAfter <= 0.f) return;
+        for (Entry& e : entries) {
+            if (!e.instance || e.id == active) continue;
+            e.idleSeconds += dt;
+            if (e.idleSeconds >= evictAfter) evict(e);
+        }
+    }
+
+    void reportMemory(MemoryReport& report) const {
+        report.add("Widgets", "Registro de niveles", sizeof(*this) + entries.capacity() * sizeof(Entry));
+        for (const Entry& e : entries) {
+            if (e.instance) e.instance->reportMemory(report);
+        }
+    }
+};
+
+// ----------------- Menú y Manejador Principal -----------------
+class GameMenu {
+// ... (Contenido de GameMenu)
+private:
+    sf::RectangleShape background;
+    LevelArena arena;
+    UIRoot ui;
+    std::vector<Button*> levelButtons; // Uno por nivel registrado, en el mismo orden
+    GameState nextState;
+    BakedFont& font;
+    BitmapText title;
+
+public:
+    GameMenu(BakedFont& f, const LevelRegistry& levels) : arena(MENU_ARENA_BYTES), nextState(GameState::Menu), font(f) {
+        background.setFillColor(sf::Color::White);
+        background.setSize(sf::Vector2f(1000, 700)); 
+        
+        float btn_w = 250.f;
+        float btn_h = 80.f;
+        float gap = 40.f;
+        float center_x = 500.f;
+        float center_y = 350.f;
+
+        // Botones en fila centrada
+        float row_w = levels.size() * btn_w + (levels.size() - 1) * gap;
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            float x = center_x - row_w / 2 + i * (btn_w + gap);
+            Button* btn = ui.add(arena.make<Button>(x, center_y - btn_h/2, btn_w, btn_h, levels.getTitle(i), font, sf::Color(150, 150, 150)));
+            GameState id = levels.getId(i);
+            btn->setOnClick([this, id]() { nextState = id; });
+            levelButtons.push_back(btn);
+        }
+
+        title.setFont(font);
+        title.setString("Simulador de Estática");
+        title.setCharacterSize(40);
+        title.setFillColor(sf::Color::Black);
+
+        sf::FloatRect bounds = title.getLocalBounds();
+        title.setOrigin(bounds.left + bounds.width/2.0f, bounds.top + bounds.height/2.0f);
+        title.setPosition(500.f, 150.f);
+        StartupProfile::instance().mark("GameMenu");
+    }
+
+    GameState handleEvent(const sf::Event& event, sf::Vector2f mousePos) {
+        nextState = GameState::Menu;
+        ui.dispatch(event, mousePos);
+        return nextState;
+    }
+
+    void commitUI() { ui.commitChanges(); }
+
+    void update(const LevelRegistry& levels) {
+        for (std::size_t i = 0; i < levelButtons.size(); ++i)
+            levelButtons[i]->setFillColor(levels.isWon(levels.getId(i)) ? sf::Color::Green : sf::Color(150, 150, 150));
+    }
+
+    void reportMemory(MemoryReport& report) const {
+        report.add("Widgets", "Menu: objeto", sizeof(*this) + levelButtons.capacity() * sizeof(Button*));
+        ui.reportMemory(report, "Menu");
+        arena.reportMemory(report, "Menu");
+        report.add("Widgets", "Menu: textos", title.getHeapBytes());
+    }
+
+    void draw(CountingRenderTarget& target) {
+        target.draw(background);
+        ui.draw(target);
+        target.draw(title);
+    }
+};
+
+
+// ----------------- Perfilador de frames -----------------
+// Overlay (F3) con el tiempo de cada fase del bucle principal: eventos, update, draw y display.
+// Guarda una ventana movil de muestras por fase (p50/p95/p99/peor) y acumula el tiempo
+// por GameState activo.
+enum class FramePhase { Events, Update, Draw, Display, Count };
+
+class FrameProfiler {
+private:
+    static const int PHASES = static_cast<int>(FramePhase::Count);
+    static const int STATES = 3;          // GameState::Menu, Level1, Level2
+    static const int HISTORY = 240;       // 4 s a 60 FPS
+    static const int REFRESH_FRAMES = 15; // Cada cuantos frames se recalcula el texto
+
+    sf::Clock clock;
+    float current[PHASES];
+    float history[PHASES][HISTORY]; // Segundos
+    int head;
+    int filled;
+    int framesSinceRefresh;
+
+    double stateTime[STATES];
+    float stateWorst[STATES];
+    long stateFrames[STATES];
+    unsigned int stateMaxDrawCalls[STATES];
+    RenderStats lastRender;
+    AllocStats lastAllocs;
+
+    bool visible;
+    sf::RectangleShape background;
+    sf::VertexArray graph;
+    BitmapText columns[5];
+    BitmapText footer;
+    std::function<void(MemoryReport&)> memorySource;
+
+    static float percentile(std::vector<float>& v, float p) {
+        if (v.empty()) return 0.f;
+        std::size_t k = static_cast<std::size_t>(p * (v.size() - 1));
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+
+    float frameTotal(int index) const {
+        float t = 0.f;
+        for (int p = 0; p < PHASES; ++p) t += history[p][index];
+        return t;
+    }
+
+    void refreshText() {
+        static const char* names[PHASES + 1] = {"Eventos", "Update", "Draw", "Display", "Frame"};
+        std::stringstream col[5];
+        col[0] << "Fase\n"; col[1] << "p50\n"; col[2] << "p95\n"; col[3] << "p99\n"; col[4] << "peor (ms)\n";
+
+        std::vector<float> samples;
+        samples.reserve(HISTORY);
+        for (int p = 0; p <= PHASES; ++p) {
+            samples.clear();
+            for (int i = 0; i < filled; ++i) samples.push_back((p < PHASES ? history[p][i] : frameTotal(i)) * 1000.f);
+            float worst = samples.empty() ? 0.f : *std::max_element(samples.begin(), samples.end());
+            col[0] << names[p] << "\n";
+            col[1] << std::fixed << std::setprecision(2) << percentile(samples, 0.50f) << "\n";
+            col[2] << std::fixed << std::setprecision(2) << percentile(samples, 0.95f) << "\n";
+            col[3] << std::fixed << std::setprecision(2) << percentile(samples, 0.99f) << "\n";
+            col[4] << std::fixed << std::setprecision(2) << worst << "\n";
+        }
+        for (int c = 0; c < 5; ++c) columns[c].setString(col[c].str());
+
+        static const char* stateNames[STATES] = {"Menu", "Nivel 1", "Nivel 2"};
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2);
+        for (int st = 0; st < STATES; ++st) {
+            if (stateFrames[st] == 0) continue;
+            ss << stateNames[st] << ": " << stateFrames[st] << " frames, media "
+               << stateTime[st] / stateFrames[st] * 1000.0 << " ms, peor " << stateWorst[st] * 1000.f
+               << " ms, max " << stateMaxDrawCalls[st] << " draws\n";
+        }
+        ss << "Frame: " << lastRender.drawCalls << " draws, " << lastRender.vertices << " vertices, "
+           << lastRender.textureBinds << " texturas, " << lastRender.stateChanges << " cambios de estado\n";
+        if (ALLOC_STATS_ENABLED) {
+            ss << "Asignaciones: " << lastAllocs.totalCount() << " (" << lastAllocs.totalBytes() << " B) -";
+            for (int i = 0; i < ALLOC_SUBSYSTEMS; ++i) ss << " " << allocSubsystemName(i) << " " << lastAllocs.count[i];
+            ss << "\n";
+        }
+        const TextRunCache& cache = TextRunCache::shared();
+        ss << "Cache de texto: " << cache.getHits() << " aciertos / " << cache.getMisses() << " fallos";
+        for (int k = 0; k < LATENCY_KINDS; ++k) {
+            LatencySummary lat = LatencyTracker::instance().summarize(static_cast<LatencyKind>(k));
+            if (lat.count == 0) continue;
+            ss << "\nLatencia " << latencyKindName(k) << " (ms): p50 " << lat.p50 / 1000.f << ", p95 " << lat.p95 / 1000.f
+               << ", peor " << lat.worst / 1000.f << " (" << lat.count << ")";
+        }
+        if (memorySource) {
+            MemoryReport memory;
+            memorySource(memory);
+            ss << std::setprecision(0) << "\nMemoria: " << memory.total() / 1024.0 << " KB -";
+            for (const auto& g : memory.groupTotals()) ss << " " << g.first << " " << g.second / 1024.0;
+        }
+        footer.setString(ss.str());
+    }
+
+    void rebuildGraph() {
+        // Barras apiladas por fase de los ultimos frames; la linea gris marca 16.6 ms
+        static const sf::Color colors[PHASES] = {sf::Color(80, 160, 255), sf::Color(120, 220, 120), sf::Color(255, 170, 60), sf::Color(200, 80, 200)};
+        const float x0 = 10.f, y0 = 290.f, barW = 1.5f, pxPerMs = 4.f;
+
+        graph.clear();
+        for (int i = 0; i < filled; ++i) {
+            int idx = (head - filled + i + HISTORY) % HISTORY;
+            float x = x0 + i * barW;
+            float y = y0;
+            for (int p = 0; p < PHASES; ++p) {
+                float h = std::min(history[p][idx] * 1000.f * pxPerMs, 100.f);
+                graph.append(sf::Vertex(sf::Vector2f(x, y), colors[p]));
+                graph.append(sf::Vertex(sf::Vector2f(x + barW, y), colors[p]));
+                graph.append(sf::Vertex(sf::Vector2f(x + barW, y - h), colors[p]));
+                graph.append(sf::Vertex(sf::Vector2f(x, y - h), colors[p]));
+                y -= h;
+            }
+        }
+        float budgetY = y0 - 1000.f / 60.f * pxPerMs;
+        graph.append(sf::Vertex(sf::Vector2f(x0, budgetY), sf::Color(200, 200, 200)));
+        graph.append(sf::Vertex(sf::Vector2f(x0 + HISTORY * barW, budgetY), sf::Color(200, 200, 200)));
+        graph.append(sf::Vertex(sf::Vector2f(x0 + HISTORY * barW, budgetY + 1), sf::Color(200, 200, 200)));
+        graph.append(sf::Vertex(sf::Vector2f(x0, budgetY + 1), sf::Color(200, 200, 200)));
+    }
+
+public:
+    FrameProfiler(BakedFont& font) : head(0), filled(0), framesSinceRefresh(0), visible(false), graph(sf::Quads) {
+        for (int p = 0; p < PHASES; ++p) current[p] = 0.f;
+        for (int st = 0; st < STATES; ++st) { stateTime[st] = 0.0; stateWorst[st] = 0.f; stateFrames[st] = 0; stateMaxDrawCalls[st] = 0; }
+        lastAllocs = AllocStats();
+
+        background.setPosition(0.f, 0.f);
+        background.setSize(sf::Vector2f(380.f, 445.f));
+        background.setFillColor(sf::Color(0, 0, 0, 190));
+
+        const float colX[5] = {10.f, 90.f, 150.f, 210.f, 270.f};
+        for (int c = 0; c < 5; ++c) {
+            columns[c].setFont(font);
+            columns[c].setCharacterSize(14);
+            columns[c].setFillColor(sf::Color::White);
+            columns[c].setPosition(colX[c], 8.f);
+        }
+        footer.setFont(font);
+        footer.setCharacterSize(12);
+        footer.setFillColor(sf::Color(220, 220, 220));
+        footer.setPosition(10.f, 296.f);
+    }
+
+    void toggle() {
+        visible = !visible;
+        if (visible) refreshText();
+    }
+    bool isVisible() const { return visible; }
+
+    // Quien rellena el informe de memoria del overlay (fuente, niveles, caches...)
+    void setMemorySource(std::function<void(MemoryReport&)> source) { memorySource = source; }
+
+    void reportMemory(MemoryReport& report) const {
+        std::size_t texts = footer.getHeapBytes();
+        for (const BitmapText& c : columns) texts += c.getHeapBytes();
+        report.add("Vertices y texturas", "Overlay del perfilador", sizeof(*this) + graph.getVertexCount() * sizeof(sf::Vertex) + texts);
+    }
+
+    void beginFrame() {
+        clock.restart();
+        for (int p = 0; p < PHASES; ++p) current[p] = 0.f;
+    }
+
+    // Atribuye a la fase el tiempo transcurrido desde la marca anterior
+    void mark(FramePhase phase) { current[static_cast<int>(phase)] += clock.restart().asSeconds(); }
+
+    float getPhaseTime(FramePhase phase) const { return current[static_cast<int>(phase)]; }
+
+    // Tiempo de CPU del frame sin contar display() (que incluye la espera del limitador)
+    float getWorkTime() const {
+        return current[static_cast<int>(FramePhase::Events)] + current[static_cast<int>(FramePhase::Update)] + current[static_cast<int>(FramePhase::Draw)];
+    }
+
+    void endFrame(GameState state, const RenderStats& render, const AllocStats& allocs) {
+        float total = 0.f;
+        for (int p = 0; p < PHASES; ++p) {
+            history[p][head] = current[p];
+            total += current[p];
+        }
+        head = (head + 1) % HISTORY;
+        filled = std::min(filled + 1, HISTORY);
+
+        int st = static_cast<int>(state);
+        stateTime[st] += total;
+        stateWorst[st] = std::max(stateWorst[st], total);
+        stateMaxDrawCalls[st] = std::max(stateMaxDrawCalls[st], render.drawCalls);
+        lastRender = render;
+        lastAllocs = allocs;
+        ++stateFrames[st];
+
+        if (visible && ++framesSinceRefresh >= REFRESH_FRAMES) {
+            framesSinceRefresh = 0;
+            refreshText();
+        }
+    }
+
+    // sf::RenderTarget o CountingRenderTarget (con --sim-thread se graba en la copia del frame)
+    template <typename Target>
+    void draw(Target& target) {
+        if (!visible) return;
+        rebuildGraph();
+        target.draw(background);
+        target.draw(graph);
+        for (int c = 0; c < 5; ++c) target.draw(columns[c]);
+        target.draw(footer);
+    }
+};
+
+// ----------------- Entrada por frame -----------------
+// pollEvent se vacia una vez por frame en InputStage. Los MouseMoved consecutivos se agrupan
+// en uno solo con la ultima posicion (se emite antes del siguiente evento discreto para
+// conservar el orden, p. ej. arrastrar y soltar en el mismo frame). La posicion logica sale
+// de las coordenadas del propio evento, sin sf::Mouse::getPosition (ida y vuelta al servidor
+// X). Asi el manejo de eventos escala con los frames y no con la frecuencia del raton.
+struct InputEvent {
+    sf::Event event;
+    sf::Vector2f mousePos; // Posicion logica que recibio el nivel
+    sf::Int64 polledUs = -1; // Marca de LatencyTracker al salir de pollEvent
+};
+
+class InputStage {
+private:
+    std::vector<InputEvent> events;
+    bool movePending;
+    InputEvent pendingMove;
+    sf::Vector2f mousePos;
+
+    void flushMove() {
+        if (!movePending) return;
+        events.push_back(pendingMove);
+        movePending = false;
+    }
+
+public:
+    InputStage() : movePending(false) { events.reserve(32); }
+
+    void setMousePos(sf::Vector2f pos) { mousePos = pos; }
+    sf::Vector2f getMousePos() const { return mousePos; }
+
+    void beginFrame() {
+        events.clear();
+        movePending = false;
+    }
+
+    void add(const sf::Event& e, const sf::RenderTarget& target, sf::Int64 polledUs) {
+        if (e.type == sf::Event::MouseMoved) {
+            mousePos = target.mapPixelToCoords(sf::Vector2i(e.mouseMove.x, e.mouseMove.y));
+            if (!movePending) pendingMove.polledUs = polledUs;
+            pendingMove.event = e;
+            pendingMove.mousePos = mousePos;
+            movePending = true;
+            return;
+        }
+        if (e.type == sf::Event::MouseButtonPressed || e.type == sf::Event::MouseButtonReleased)
+            mousePos = target.mapPixelToCoords(sf::Vector2i(e.mouseButton.x, e.mouseButton.y));
+        flushMove();
+        events.push_back(InputEvent{e, mousePos, polledUs});
+    }
+
+    // Eventos del frame ya agrupados, en orden
+    const std::vector<InputEvent>& finish() {
+        flushMove();
+        return events;
+    }
+};
+
+// Maquina de estados del juego (menu y niveles), compartida por el modo ventana y el headless
+class Game {
+private:
+    LevelCatalogue catalogue; // Los niveles guardan referencias a sus partes
+    std::string cataloguePath;
+    FileWatcher catalogueWatcher;
+    LevelRegistry levels;
+    GameMenu menu;
+    GameState currentState;
+    SimulationBase* activeLevel; // nullptr en el menu
+    SaveWriter saver;
+    bool saveDirty;
+    sf::Uint32 savedRevision; // De activeLevel en la ultima instantanea
+
+    LevelRegistry& registerLevels() {
+        levels.add(GameState::Level1, "NIVEL 1: Plano Inclinado", [this](BakedFont& f) -> std::unique_ptr<SimulationBase> { return std::make_unique<Simulator>(f, catalogue.incline); });
+        levels.add(GameState::Level2, "NIVEL 2: Sube y Baja", [this](BakedFont& f) -> std::unique_ptr<SimulationBase> { return std::make_unique<SeesawSimulator>(f, catalogue.seesaw); });
+        return levels;
+    }
+
+    void reloadCatalogue() {
+        sf::Clock clock;
+        std::string error;
+        if (!catalogue.loadFile(cataloguePath, error)) {
+            std::cerr << "Aviso: " << cataloguePath << ": " << error << "; se mantiene el catalogo anterior" << std::endl;
+            return;
+        }
+        levels.invalidate(currentState);
+        saveDirty = true;
+        std::cerr << "Catalogo de niveles recargado en " << clock.getElapsedTime().asMicroseconds() << " us" << std::endl;
+    }
+
+    // Una instantanea cuando cambia algo; si la cola esta llena se reintenta en el frame siguiente
+    void saveIfChanged() {
+        if (activeLevel && activeLevel->getStateRevision() != savedRevision) {
+            savedRevision = activeLevel->getStateRevision();
+            saveDirty = true;
+        }
+        if (!saveDirty) return;
+        SaveFile file;
+        levels.snapshot(file);
+        if (saver.submit(file)) saveDirty = false;
+    }
+
+public:
+    Game(BakedFont& font, const LevelCatalogue& cat)
+        : catalogue(cat), levels(font), menu(font, registerLevels()), currentState(GameState::Menu), activeLevel(nullptr),
+          saveDirty(false), savedRevision(0) {}
+
+    ~Game() {
+        // El ultimo cambio se encola aunque haya que esperar a que se vacie la cola
+        while (saver.isRunning()) {
+            saveIfChanged();
+            if (!saveDirty) break;
+            sf::sleep(sf::milliseconds(SAVE_POLL_MS));
+        }
+        saver.stop();
+    }
+
+    // Carga la partida (si existe) y guarda los cambios a partir de ahora. Antes de entrar en
+    // ningun nivel. Solo en ventana sin --record/--replay: headless y las grabaciones empiezan de cero.
+    void enableSave(const std::string& path) {
+        MappedFile mapped;
+        if (mapped.open(path)) {
+            std::string error;
+            const SaveFile* file = checkSaveFile(mapped.getData(), mapped.getSize(), error);
+            if (file) {
+                levels.restore(*file);
+                saver.setSequence(file->sequence);
+            } else {
+                std::cerr << "Aviso: " << path << ": " << error << "; se empieza una partida nueva" << std::endl;
+            }
+        }
+        saver.start(path);
+    }
+
+    // Recarga el catalogo cuando cambie el archivo (solo en ventana: headless es determinista)
+    void watchCatalogue(const std::string& path) {
+        cataloguePath = path;
+        if (!catalogueWatcher.watch(path)) std::cerr << "Aviso: no se puede vigilar " << path << std::endl;
+    }
+
+    GameState getState() const { return currentState; }
+    void setState(GameState state) {
+        if (activeLevel) levels.leave(currentState);
+        currentState = state;
+        activeLevel = (state == GameState::Menu) ? nullptr : levels.enter(state);
+        if (!activeLevel) currentState = GameState::Menu;
+        savedRevision = activeLevel ? activeLevel->getStateRevision() : 0;
+        saveDirty = true; // Visitas y niveles ganados
+    }
+
+    // Segundos sin usar tras los que se destruye un nivel (0: nunca)
+    void setLevelEviction(float seconds) { levels.setEvictAfter(seconds); }
+
+    void reportMemory(MemoryReport& report) const {
+        menu.reportMemory(report);
+        levels.reportMemory(report);
+    }
+
+    // Una instantanea de entrada por frame: los eventos agrupados de InputStage
+    void handleInput(const std::vector<InputEvent>& events) {
+        for (const InputEvent& e : events) {
+            LatencyTracker::instance().beginEvent(e.polledUs);
+            handleEvent(e.event, e.mousePos);
+            LatencyTracker::instance().endEvent();
+        }
+        // Los cambios de los sliders arrastrados en este frame se publican una sola vez
+        if (activeLevel) activeLevel->commitUI();
+        else menu.commitUI();
+    }
+
+    void handleEvent(const sf::Event& event, sf::Vector2f mousePos) {
+        TRACE_SCOPE("Game::handleEvent");
+        if (!activeLevel) {
+            GameState nextState = menu.handleEvent(event, mousePos);
+            if (nextState != GameState::Menu) setState(nextState);
+        } else if (activeLevel->handleEvents(event, mousePos) == 0) {
+            setState(GameState::Menu);
+        }
+    }
+
+    void update(float dt) {
+        if (catalogueWatcher.changed()) reloadCatalogue();
+        if (activeLevel) activeLevel->update(dt);
+        levels.tick(dt, currentState);
+        if (saver.isRunning()) saveIfChanged();
+    }
+
+    void draw(CountingRenderTarget& target, ResolutionScaler& scaler) {
+        TRACE_SCOPE("Game::draw");
+        if (activeLevel) {
+            activeLevel->draw(target, scaler);
+        } else {
+            menu.update(levels);
+            menu.draw(target);
+        }
+    }
+};
+
+// ----------------- Grabacion y reproduccion de entrada -----------------
+// --record guarda los eventos de entrada de una sesion real en un log binario compacto;
+// --replay / --replay-headless los vuelven a inyectar en el mismo frame y con la misma
+// semilla de rand(), de modo que la sesion se reproduce igual.
+// Formato (little-endian): "FSRP", u16 version, u32 semilla, y registros:
+//   u16 frames desde el registro anterior, u8 tipo, f32 raton x, f32 raton y, datos del tipo
+// El registro de tipo REPLAY_END lleva el numero total de frames de la sesion; REPLAY_SKIP
+// solo avanza frames (pausas de mas de 65535) y no genera ningun evento.
+// Version 1: las pausas largas se partian con MouseMoved reales; se siguen leyendo.
+const sf::Uint16 REPLAY_VERSION = 2;
+const sf::Uint8 REPLAY_END = 255;
+const sf::Uint8 REPLAY_SKIP = 254;
+
+struct ReplayEvent {
+    unsigned int frame;
+    InputEvent input;
+};
+
+bool isRecordableEvent(const sf::Event& e) {
+    return e.type == sf::Event::MouseMoved || e.type == sf::Event::MouseButtonPressed || e.type == sf::Event::MouseButtonReleased
+        || e.type == sf::Event::TextEntered || e.type == sf::Event::KeyPressed;
+}
+
+class InputRecorder {
+private:
+    std::ofstream out;
+    unsigned int lastFrame;
+
+    void writeU8(sf::Uint8 v) { out.put(static_cast<char>(v)); }
+    void writeU16(sf::Uint16 v) { writeU8(v & 0xFF); writeU8(v >> 8); }
+    void writeU32(sf::Uint32 v) { writeU16(v & 0xFFFF); writeU16(v >> 16); }
+    void writeI16(int v) { writeU16(static_cast<sf::Uint16>(static_cast<sf::Int16>(v))); }
+    void writeF32(float v) { sf::Uint32 u; std::memcpy(&u, &v, 4); writeU32(u); }
+
+    void writeHeader(unsigned int frame, sf::Uint8 type, sf::Vector2f mouse) {
+        // Pausas de mas de 65535 frames se parten en registros que el lector salta
+        while (frame - lastFrame > 0xFFFF) {
+            writeU16(0xFFFF); writeU8(REPLAY_SKIP); writeF32(0.f); writeF32(0.f);
+            lastFrame += 0xFFFF;
+        }
+        writeU16(static_cast<sf::Uint16>(frame - lastFrame));
+        writeU8(type);
+        writeF32(mouse.x);
+        writeF32(mouse.y);
+        lastFrame = frame;
+    }
+
+public:
+    InputRecorder() : lastFrame(0) {}
+
+    bool open(const std::string& path, unsigned int seed) {
+        out.open(path, std::ios::binary);
+        if (!out) return false;
+        out.write("FSRP", 4);
+        writeU16(REPLAY_VERSION);
+        writeU32(seed);
+        return true;
+    }
+
+    bool isOpen() const { return out.is_open(); }
+
+    void record(unsigned int frame, const sf::Event& e, sf::Vector2f mouse) {
+        if (!out.is_open() || !isRecordableEvent(e)) return;
+        writeHeader(frame, static_cast<sf::Uint8>(e.type), mouse);
+        switch (e.type) {
+            case sf::Event::MouseMoved: writeI16(e.mouseMove.x); writeI16(e.mouseMove.y); break;
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased: writeU8(static_cast<sf::Uint8>(e.mouseButton.button)); writeI16(e.mouseButton.x); writeI16(e.mouseButton.y); break;
+            case sf::Event::TextEntered: writeU32(e.text.unicode); break;
+            case sf::Event::KeyPressed: writeI16(e.key.code); break;
+            default: break;
+        }
+    }
+
+    void close(unsigned int totalFrames) {
+        if (!out.is_open()) return;
+        writeHeader(totalFrames, REPLAY_END, sf::Vector2f());
+        out.close();
+    }
+};
+
+class InputReplay {
+private:
+    std::vector<ReplayEvent> events;
+    unsigned int totalFrames;
+    unsigned int seed;
+    std::size_t cursor;
+
+public:
+    InputReplay() : totalFrames(0), seed(1), cursor(0) {}
+
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::size_t pos = 0;
+        auto has = [&](std::size_t n) { return pos + n <= data.size(); };
+        auto u8 = [&]() { return static_cast<sf::Uint8>(data[pos++]); };
+        auto u16 = [&]() { sf::Uint16 lo = u8(); return static_cast<sf::Uint16>(lo | (u8() << 8)); };
+        auto u32 = [&]() { sf::Uint32 lo = u16(); return lo | (static_cast<sf::Uint32>(u16()) << 16); };
+        auto i16 = [&]() { return static_cast<int>(static_cast<sf::Int16>(u16())); };
+        auto f32 = [&]() { sf::Uint32 u = u32(); float f; std::memcpy(&f, &u, 4); return f; };
+
+        if (!has(10) || std::string(data.data(), 4) != "FSRP") return false;
+        pos = 4;
+        sf::Uint16 version = u16();
+        if (version < 1 || version > REPLAY_VERSION) return false;
+        seed = u32();
+
+        unsigned int frame = 0;
+        while (has(11)) {
+            frame += u16();
+            sf::Uint8 type = u8();
+            ReplayEvent r;
+            r.frame = frame;
+            r.input.mousePos.x = f32();
+            r.input.mousePos.y = f32();
+            if (type == REPLAY_END) {
+                totalFrames = frame;
+                return true;
+            }
+            if (type == REPLAY_SKIP) continue;
+
+            sf::Event& e = r.input.event;
+            e.type = static_cast<sf::Event::EventType>(type);
+            switch (e.type) {
+                case sf::Event::MouseMoved:
+                    if (!has(4)) return false;
+                    e.mouseMove.x = i16(); e.mouseMove.y = i16(); break;
+                case sf::Event::MouseButtonPressed:
+                case sf::Event::MouseButtonReleased:
+                    if (!has(5)) return false;
+                    e.mouseButton.button = static_cast<sf::Mouse::Button>(u8()); e.mouseButton.x = i16(); e.mouseButton.y = i16(); break;
+                case sf::Event::TextEntered:
+                    if (!has(4)) return false;
+                    e.text.unicode = u32(); break;
+                case sf::Event::KeyPressed:
+                    if (!has(2)) return false;
+                    e.key = sf::Event::KeyEvent(); e.key.code = static_cast<sf::Keyboard::Key>(i16()); break;
+                default:
+                    return false;
+            }
+            events.push_back(r);
+        }
+        // Sin registro final (sesion cortada): se reproduce hasta el ultimo evento
+        totalFrames = events.empty() ? 0 : events.back().frame + 1;
+        return true;
+    }
+
+    unsigned int getSeed() const { return seed; }
+    unsigned int getTotalFrames() const { return totalFrames; }
+    bool finished(unsigned int frame) const { return frame >= totalFrames; }
+
+    // Anade a out los eventos grabados para este frame
+    void eventsForFrame(unsigned int frame, std::vector<InputEvent>& out) {
+        while (cursor < events.size() && events[cursor].frame <= frame) {
+            out.push_back(events[cursor].input);
+            ++cursor;
+        }
     }
+};
 
+// Resumen de coste por frame de una reproduccion (tiempo de trabajo, sin la espera de display)
+void printReplaySummary(std::vector<float> frameUs) {
+    if (frameUs.empty()) return;
+    std::sort(frameUs.begin(), frameUs.end());
+    auto pct = [&](float p) { return frameUs[static_cast<std::size_t>(p * (frameUs.size() - 1))]; };
+    double sum = 0.0;
+    for (float v : frameUs) sum += v;
+    std::cerr << "Reproduccion: " << frameUs.size() << " frames, media " << sum / frameUs.size() << " us, p50 " << pct(0.5f)
+              << " us, p95 " << pct(0.95f) << " us, p99 " << pct(0.99f) << " us, peor " << frameUs.back() << " us" << std::endl;
+}
 
-    void setupUI() {
-        float input_x = 50.f;
-        float input_y = 50.f;
-        float input_w = 120.f;
-        float input_h = 30.f;
-        float button_w = 180.f;
-        float button_h = 40.f;
-        
-        inputWeightP2 = new InputBox(input_x, input_y + 30, input_w, input_h, font);
+// ----------------- Modo headless (sin ventana) -----------------
+// Ejecuta un guion de escenario dibujando cada frame en un sf::RenderTexture, sin abrir
+// sf::RenderWindow. Por frame escribe una linea CSV (frame, estado, tiempos, hash de la imagen)
+// y opcionalmente guarda el PNG. Formato del guion, un comando por linea (# = comentario):
+//   level menu|1|2        cambia de estado directamente
+//   move X Y              mueve el raton (coordenadas logicas 1000x700)
+//   press X Y / release X Y
+//   click X Y             move + press + release
+//   type TEXTO            un TextEntered por caracter
+//   backspace
+//   wait N                dibuja N frames
+//   steady N              dibuja N frames sin eventos y exige cero asignaciones de memoria en
+//                         cada uno (requiere FISICA_ALLOC_STATS); si falla termina con codigo 3
+//   budget draws N        maximo de draw calls por frame en el estado actual (0 = sin limite);
+//                         si algun frame lo supera el proceso termina con codigo 2
+// Los eventos se entregan al inicio del siguiente frame dibujado.
+struct HeadlessOptions {
+    std::string scriptPath;
+    std::string replayPath; // Alternativa al guion: log grabado con --record
+    std::string framesDir;  // Vacio = no guardar PNG
+    std::string reportPath; // Vacio = stdout
+    unsigned int seed;
+};
 
-        btnCalculate = new Button(input_x, input_y + 80, button_w, button_h, "Calcular Equilibrio", font, sf::Color(0,100,180));
-        btnNewGame = new Button(input_x, input_y + 130, button_w, button_h, "Nuevo Juego", font, sf::Color(200,100,0));
-        
-        sf::Text labelInput;
-        labelInput.setFont(font); labelInput.setString("Peso P2 (kg):"); labelInput.setPosition(input_x, input_y); labelInput.setCharacterSize(18);
-        
-        msgLabel.setPosition(input_x, input_y + 190);
-        msgLabel.setCharacterSize(22);
-        
-        tooltip = new Tooltip(font);
-        
-        forceP1 = new ForceArrow("Momento P1", "Peso * Distancia", sf::Color::Red, font, "Seesaw");
-        forceP2 = new ForceArrow("Momento P2", "Peso * Distancia", sf::Color::Blue, font, "Seesaw");
+const char* stateName(GameState state) {
+    switch (state) {
+        case GameState::Menu: return "menu";
+        case GameState::Level1: return "level1";
+        case GameState::Level2: return "level2";
     }
+    return "?";
+}
 
-    void setupGeometry() {
-        base.setSize(sf::Vector2f(20.f, 100.f));
-        base.setOrigin(10.f, 0.f);
-        base.setPosition(PIVOT_X, PIVOT_Y);
-        base.setFillColor(sf::Color(100, 100, 100));
-        
-        pivot.setRadius(15.f);
-        pivot.setOrigin(15.f, 15.f);
-        pivot.setPosition(PIVOT_X, PIVOT_Y);
-        pivot.setFillColor(sf::Color::Black);
+// FNV-1a de 64 bits sobre los pixeles RGBA
+sf::Uint64 hashImage(const sf::Image& image) {
+    sf::Uint64 h = 14695981039346656037ULL;
+    const sf::Uint8* px = image.getPixelsPtr();
+    std::size_t n = static_cast<std::size_t>(image.getSize().x) * image.getSize().y * 4;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= px[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
 
-        board.setSize(sf::Vector2f(BOARD_WIDTH, BOARD_HEIGHT));
-        board.setOrigin(BOARD_WIDTH / 2.f, BOARD_HEIGHT / 2.f);
-        board.setPosition(PIVOT_X, PIVOT_Y - BOARD_HEIGHT / 2.f);
-        board.setFillColor(sf::Color(139, 69, 19)); 
-        
-        person1.setRadius(20.f); person1.setOrigin(20.f, 20.f); person1.setFillColor(sf::Color::Yellow); person1.setOutlineColor(sf::Color::Black); person1.setOutlineThickness(2.f);
-        person2.setRadius(20.f); person2.setOrigin(20.f, 20.f); person2.setFillColor(sf::Color::Cyan); person2.setOutlineColor(sf::Color::Black); person2.setOutlineThickness(2.f);
+sf::Event makeMouseEvent(sf::Event::EventType type, int x, int y) {
+    sf::Event e;
+    e.type = type;
+    if (type == sf::Event::MouseMoved) {
+        e.mouseMove.x = x;
+        e.mouseMove.y = y;
+    } else {
+        e.mouseButton.button = sf::Mouse::Left;
+        e.mouseButton.x = x;
+        e.mouseButton.y = y;
     }
-    
-    void resetGame() {
-        // Lógica de generación con comprobación de decimales en la respuesta
-        do {
-            // P1: Peso [50, 120] kg
-            weightP1 = randomInt(50, 120);
-            // P1: Distancia múltiplo de 20 en [20, 100] cm
-            distP1 = randomMultipleInt(20, 100, 20);
-            
-            // P2: Distancia [10, 100] cm
-            distP2 = randomInt(10, 100);
+    return e;
+}
 
-            // Cálculo de la respuesta correcta: Peso₂ = (Peso₁ * Distancia₁) / Distancia₂
-            correctWeightP2 = (weightP1 * distP1) / (float)distP2;
-            
-        } while (!hasMaxFourDecimals(correctWeightP2));
+sf::Event makeTextEvent(sf::Uint32 unicode) {
+    sf::Event e;
+    e.type = sf::Event::TextEntered;
+    e.text.unicode = unicode;
+    return e;
+}
 
-        // UI y estado
-        inputWeightP2->clear();
-        isWon = false;
-        weightP2_input = 0.f;
-        momentP1 = 0.f;
-        momentP2 = 0.f;
-        
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(2) << correctWeightP2;
+int runHeadless(const HeadlessOptions& options) {
+    std::ifstream script;
+    InputReplay replay;
+    if (!options.replayPath.empty()) {
+        if (!replay.load(options.replayPath)) {
+            std::cerr << "Error: No se pudo leer la grabacion " << options.replayPath << std::endl;
+            return -1;
+        }
+        std::srand(replay.getSeed());
+    } else {
+        script.open(options.scriptPath);
+        if (!script) {
+            std::cerr << "Error: No se pudo abrir el guion " << options.scriptPath << std::endl;
+            return -1;
+        }
+        std::srand(options.seed);
+    }
 
-        //msgLabel.setString("Ingresa el peso de P2 para equilibrar.\nRespuesta requerida: " + ss.str() + " kg"); // Mostrar la respuesta para propósitos de prueba
-        msgLabel.setFillColor(sf::Color::Black);
-        
-        forceP1->update(sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
-        forceP2->update(sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+    sf::RenderTexture target;
+    if (!target.create(1000, 700)) {
+        std::cerr << "Error: No se pudo crear el RenderTexture (contexto OpenGL)" << std::endl;
+        return -1;
+    }
 
-        updateVisualState();
+    BakedFont font;
+    if (!font.loadEmbedded()) {
+        std::cerr << "Error: No se pudo crear la textura de la fuente" << std::endl;
+        return -1;
     }
-    
-    void calculateEquilibrium() {
-        weightP2_input = inputWeightP2->getValue();
-        
-        if (weightP2_input <= 0.01f) {
-            msgLabel.setString("¡Ingresa un peso valido para P2!");
-            msgLabel.setFillColor(sf::Color::Red);
-            updateVisualState();
-            return;
+
+    std::ofstream reportFile;
+    if (!options.reportPath.empty()) reportFile.open(options.reportPath);
+    std::ostream& report = options.reportPath.empty() ? std::cout : reportFile;
+    report << "frame,state,events_us,draw_us,draw_calls,vertices,texture_binds,state_changes,allocs,alloc_bytes,latency_us,hash\n";
+
+    // Catalogo por defecto: los hashes y presupuestos no deben depender de niveles.cfg
+    Game game(font, LevelCatalogue());
+    ResolutionScaler scaler; // Desactivado: la salida debe ser determinista
+    std::vector<InputEvent> pending;
+    sf::Vector2f mousePos(0.f, 0.f);
+    std::vector<float> frameUs;
+    unsigned int frame = 0;
+    unsigned int drawBudget[3] = {0, 0, 0}; // Por GameState
+    bool budgetExceeded = false;
+    unsigned long long lastFrameAllocs = 0;
+    bool steadyAllocFailed = false;
+
+    auto renderFrame = [&]() {
+        sf::Clock clock;
+        AllocStats allocsBefore = allocStatsNow();
+        {
+            ALLOC_SCOPE(AllocSubsystem::Events);
+            game.handleInput(pending);
+            pending.clear();
         }
-        
-        momentP1 = weightP1 * distP1;
-        momentP2 = weightP2_input * distP2;
-        
-        // Criterio de Equilibrio: Peso de usuario vs. Peso correcto (precalculado)
-        // Usamos la tolerancia para aceptar respuestas cercanas, incluyendo redondeo.
-        float inputRatio = weightP2_input / correctWeightP2;
-        
-        if (std::abs(inputRatio - 1.0f) <= (EPSILON / correctWeightP2)) { // Normalizar la tolerancia
-            // ¡EQUILIBRIO!
-            isWon = true;
-            msgLabel.setString("¡EQUILIBRIO LOGRADO! GANASTE.");
-            msgLabel.setFillColor(sf::Color::Green);
-        } else {
-            // DESEQUILIBRIO
-            isWon = false;
-            msgLabel.setString("DESEQUILIBRIO: Ingresa otro peso.");
-            msgLabel.setFillColor(sf::Color::Red);
+        {
+            ALLOC_SCOPE(AllocSubsystem::Update);
+            game.update(1.f / 60.f);
+        }
+        sf::Int64 eventsUs = clock.restart().asMicroseconds();
+
+        RenderStats renderStats;
+        {
+            ALLOC_SCOPE(AllocSubsystem::Draw);
+            CountingRenderTarget counted(target, renderStats);
+            game.draw(counted, scaler);
+            target.display();
+        }
+        // La captura de la imagen y el informe no cuentan como asignaciones del frame
+        AllocStats allocs = allocStatsNow().since(allocsBefore);
+        lastFrameAllocs = allocs.totalCount();
+        sf::Image image = target.getTexture().copyToImage(); // Fuerza a terminar el trabajo de la GPU
+        LatencyTracker::instance().displayed();
+        sf::Int64 drawUs = clock.restart().asMicroseconds();
+        frameUs.push_back(static_cast<float>(eventsUs + drawUs));
+
+        if (!options.framesDir.empty()) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%05u.png", frame);
+            image.saveToFile(options.framesDir + name);
         }
 
-        updateVisualState();
-    }
+        unsigned int budget = drawBudget[static_cast<int>(game.getState())];
+        if (budget > 0 && renderStats.drawCalls > budget) {
+            std::cerr << "Presupuesto excedido en frame " << frame << " (" << stateName(game.getState()) << "): "
+                      << renderStats.drawCalls << " draw calls > " << budget << std::endl;
+            budgetExceeded = true;
+        }
 
-    void updateVisualState() {
-        float max_angle = 15.f; 
-        float max_moment = 120.f * 100.f; 
-        float angle = 0.f;
-        
-        if (!isWon) {
-            float moment_diff = momentP1 - momentP2; 
-            angle = moment_diff / max_moment * max_angle;
-            angle = std::max(-max_angle, std::min(max_angle, angle));
+        report << frame << "," << stateName(game.getState()) << "," << eventsUs << "," << drawUs << ","
+               << renderStats.drawCalls << "," << renderStats.vertices << "," << renderStats.textureBinds << ","
+               << renderStats.stateChanges << "," << allocs.totalCount() << "," << allocs.totalBytes() << ","
+               << static_cast<int>(LatencyTracker::instance().getFrameWorst()) << ","
+               << std::hex << std::setw(16) << std::setfill('0') << hashImage(image) << std::dec << std::setfill(' ') << "\n";
+        ++frame;
+    };
+
+    // Los eventos del guion llevan la posicion del raton que tendria el nivel en ese momento
+    auto push = [&](const sf::Event& e) {
+        if (e.type == sf::Event::MouseMoved) mousePos = sf::Vector2f((float)e.mouseMove.x, (float)e.mouseMove.y);
+        else if (e.type == sf::Event::MouseButtonPressed || e.type == sf::Event::MouseButtonReleased)
+            mousePos = sf::Vector2f((float)e.mouseButton.x, (float)e.mouseButton.y);
+        pending.push_back(InputEvent{e, mousePos, LatencyTracker::instance().now()});
+    };
+
+    if (!options.replayPath.empty()) {
+        while (!replay.finished(frame)) {
+            replay.eventsForFrame(frame, pending);
+            renderFrame();
         }
-        
-        board.setRotation(angle);
-        
-        float rad_angle = toRad(angle);
-        float y_offset = PIVOT_Y - BOARD_HEIGHT / 2.f;
-        
-        // P1 (izquierda, Distancia = distP1)
-        float p1_dist_from_center = -(float)distP1 * BOARD_WIDTH / 200.f; 
-        float p1_x = PIVOT_X + p1_dist_from_center * std::cos(rad_angle);
-        float p1_y = y_offset + p1_dist_from_center * std::sin(rad_angle);
-        
-        // P2 (derecha, Distancia = distP2)
-        float p2_dist_from_center = (float)distP2 * BOARD_WIDTH / 200.f; 
-        float p2_x = PIVOT_X + p2_dist_from_center * std::cos(rad_angle);
-        float p2_y = y_offset + p2_dist_from_center * std::sin(rad_angle);
+        printReplaySummary(frameUs);
+    }
 
-        person1.setPosition(p1_x, p1_y - person1.getRadius());
-        person2.setPosition(p2_x, p2_y - person2.getRadius());
-        
-        if (weightP2_input > 0.01f) {
-            float scale_factor = 0.01f; 
-            
-            forceP1->update(person1.getPosition() + sf::Vector2f(0, 20), sf::Vector2f(0, 1), weightP1 * G, scale_factor);
-            forceP2->update(person2.getPosition() + sf::Vector2f(0, 20), sf::Vector2f(0, 1), weightP2_input * G, scale_factor);
+    std::string line;
+    int lineNo = 0;
+    while (script.is_open() && std::getline(script, line)) {
+        ++lineNo;
+        std::istringstream in(line);
+        std::string cmd;
+        if (!(in >> cmd) || cmd[0] == '#') continue;
+
+        int x = 0, y = 0;
+        if (cmd == "level") {
+            std::string which; in >> which;
+            if (which == "1") game.setState(GameState::Level1);
+            else if (which == "2") game.setState(GameState::Level2);
+            else game.setState(GameState::Menu);
+        } else if (cmd == "move" && (in >> x >> y)) {
+            push(makeMouseEvent(sf::Event::MouseMoved, x, y));
+        } else if (cmd == "press" && (in >> x >> y)) {
+            push(makeMouseEvent(sf::Event::MouseButtonPressed, x, y));
+        } else if (cmd == "release" && (in >> x >> y)) {
+            push(makeMouseEvent(sf::Event::MouseButtonReleased, x, y));
+        } else if (cmd == "click" && (in >> x >> y)) {
+            push(makeMouseEvent(sf::Event::MouseMoved, x, y));
+            push(makeMouseEvent(sf::Event::MouseButtonPressed, x, y));
+            push(makeMouseEvent(sf::Event::MouseButtonReleased, x, y));
+        } else if (cmd == "type") {
+            std::string text; in >> text;
+            for (char c : text) push(makeTextEvent(static_cast<sf::Uint32>(c)));
+        } else if (cmd == "backspace") {
+            push(makeTextEvent(8));
+        } else if (cmd == "budget") {
+            std::string what; unsigned int n = 0;
+            if ((in >> what >> n) && what == "draws") drawBudget[static_cast<int>(game.getState())] = n;
+            else std::cerr << "Aviso: linea " << lineNo << " del guion no reconocida: " << line << std::endl;
+        } else if (cmd == "steady") {
+            int n = 1; in >> n;
+            if (!ALLOC_STATS_ENABLED) std::cerr << "Aviso: 'steady' requiere compilar con -DFISICA_ALLOC_STATS (make allocstats)" << std::endl;
+            for (int i = 0; i < n; ++i) {
+                renderFrame();
+                if (lastFrameAllocs > 0) {
+                    std::cerr << "Asignaciones en estado estable: frame " << (frame - 1) << " (" << stateName(game.getState())
+                              << ") hizo " << lastFrameAllocs << " asignaciones" << std::endl;
+                    steadyAllocFailed = true;
+                }
+            }
+        } else if (cmd == "wait") {
+            int n = 1; in >> n;
+            for (int i = 0; i < n; ++i) renderFrame();
         } else {
-            forceP1->update(sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
-            forceP2->update(sf::Vector2f(0,0), sf::Vector2f(0,0), 0.f, 1.f);
+            std::cerr << "Aviso: linea " << lineNo << " del guion no reconocida: " << line << std::endl;
         }
     }
-    
-    void drawData(sf::RenderWindow& window) {
-        float x_left_p1 = PIVOT_X - (float)distP1 * BOARD_WIDTH / 200.f;
-        float x_right_p2 = PIVOT_X + (float)distP2 * BOARD_WIDTH / 200.f;
-        float y_dist = PIVOT_Y + 50.f;
+    if (!pending.empty() || frame == 0) renderFrame();
+    LatencyTracker::instance().printSummary(std::cerr);
+
+#ifdef FISICA_TRACE
+    TraceRecorder::instance().writeJson("trace.json");
+#endif
+    if (steadyAllocFailed) return 3;
+    return budgetExceeded ? 2 : 0;
+}
 
-        drawDashedLine(window, PIVOT_X, PIVOT_Y, x_left_p1, y_dist, sf::Color::Black);
-        drawDashedLine(window, PIVOT_X, y_dist, x_left_p1, y_dist, sf::Color::Blue);
-        
-        sf::Text distTxt1;
-        distTxt1.setFont(font); distTxt1.setCharacterSize(14); distTxt1.setFillColor(sf::Color::Blue);
-        std::stringstream ss1; ss1 << std::fixed << std::setprecision(0) << (float)distP1 << " cm";
-        distTxt1.setString(ss1.str());
-        distTxt1.setPosition(PIVOT_X - (float)distP1 * BOARD_WIDTH / 400.f - 20, y_dist + 5);
-        window.draw(distTxt1);
 
-        drawDashedLine(window, PIVOT_X, PIVOT_Y, x_right_p2, y_dist, sf::Color::Black);
-        drawDashedLine(window, PIVOT_X, y_dist, x_right_p2, y_dist, sf::Color::Red);
-        
-        sf::Text distTxt2;
-        distTxt2.setFont(font); distTxt2.setCharacterSize(14); distTxt2.setFillColor(sf::Color::Red);
-        std::stringstream ss2; ss2 << std::fixed << std::setprecision(0) << (float)distP2 << " cm";
-        distTxt2.setString(ss2.str());
-        distTxt2.setPosition(PIVOT_X + (float)distP2 * BOARD_WIDTH / 400.f - 20, y_dist + 5);
-        window.draw(distTxt2);
-        
-        float data_x = 700.f;
-        float data_y = 50.f;
-        float line_spacing = 25.f;
-        
-        auto drawDataLine = [&](float y, const std::string& label, const std::string& value, sf::Color color) {
-            sf::Text labelTxt; labelTxt.setFont(font); labelTxt.setCharacterSize(16); labelTxt.setFillColor(sf::Color::Black);
-            labelTxt.setString(label); labelTxt.setPosition(data_x, y); window.draw(labelTxt);
-            
-            sf::Text valueTxt; valueTxt.setFont(font); valueTxt.setCharacterSize(16); valueTxt.setFillColor(color);
-            valueTxt.setString(value); valueTxt.setPosition(data_x + 150, y); window.draw(valueTxt);
-        };
-        
-        std::stringstream ssW1, ssW2, ssM1, ssM2;
-        ssW1 << std::fixed << std::setprecision(0) << weightP1 << " kg";
-        ssW2 << std::fixed << std::setprecision(2) << weightP2_input << " kg (Input)";
-        ssM1 << std::fixed << std::setprecision(2) << momentP1 << " N*cm";
-        ssM2 << std::fixed << std::setprecision(2) << momentP2 << " N*cm";
-
-        drawDataLine(data_y + 0*line_spacing, "P1 Peso:", ssW1.str(), sf::Color::Yellow);
-        drawDataLine(data_y + 1*line_spacing, "P1 Distancia:", std::to_string(distP1) + " cm", sf::Color::Blue);
-        drawDataLine(data_y + 2*line_spacing, "P1 Momento:", ssM1.str(), sf::Color::Red);
-        
-        drawDataLine(data_y + 4*line_spacing, "P2 Peso:", ssW2.str(), sf::Color::Cyan);
-        drawDataLine(data_y + 5*line_spacing, "P2 Distancia:", std::to_string(distP2) + " cm", sf::Color::Red);
-        drawDataLine(data_y + 6*line_spacing, "P2 Momento:", ssM2.str(), sf::Color::Blue);
+// ----------------- Hilo de simulacion (--sim-thread) -----------------
+// Opcional: el hilo principal lee los eventos de la ventana, dibuja y presenta. Un hilo de
+// simulacion (sf::Thread) maneja la entrada, hace update y graba cada frame en una
+// DrawSnapshot: copias de las figuras con su transform, de los vertices de flechas, textos
+// y graficas. La entrada le llega por una cola SPSC sin locks y las copias vuelven por un
+// triple buffer; el hilo principal dibuja siempre la ultima publicada, que ya nadie
+// modifica. Las llamadas a OpenGL (draw, display) quedan todas en el hilo principal, asi
+// que ni un draw lento ni el vsync retrasan la entrada y el update; grabar es solo copiar
+// memoria. --adaptive-res no se aplica en este modo: la escena se graba a resolucion nativa.
+const sf::Int64 SIM_TICK_US = 16667;   // Paso sin entrada: 60 Hz
+const sf::Int64 SIM_MIN_STEP_US = 4000; // Con entrada: como mucho 250 pasos por segundo
+
+// Tres copias de frame: una la graba la simulacion, otra la dibuja el hilo principal y la
+// tercera guarda el ultimo frame publicado. Solo se intercambian indices con un atomico.
+class FrameTripleBuffer {
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4; // Publicado y aun no recogido
+
+    DrawSnapshot frames[3];
+    unsigned int seq[3];
+    std::atomic<int> middle;
+    int back;  // Solo lo toca la simulacion
+    int front; // Solo lo toca el hilo principal
+
+public:
+    FrameTripleBuffer() : middle(1), back(0), front(2) {
+        for (int i = 0; i < 3; ++i) seq[i] = 0;
     }
-    
-    void drawDashedLine(sf::RenderWindow& window, float x1, float y1, float x2, float y2, sf::Color color) {
-        const float segment_length = 5.f;
-        const float gap_length = 3.f;
 
-        float dx = x2 - x1;
-        float dy = y2 - y1;
-        float length = std::sqrt(dx*dx + dy*dy);
-        
-        if (length < segment_length) return;
+    // Vacia la copia trasera para grabar el frame siguiente
+    DrawSnapshot& beginBack() {
+        frames[back].reset();
+        return frames[back];
+    }
 
-        sf::Vector2f dir_unit(dx / length, dy / length);
+    // El exchange con release hace visible la copia entera al hilo que la recoja
+    void publish(unsigned int frameSeq) {
+        seq[back] = frameSeq;
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
 
-        float current_pos = 0;
-        while (current_pos < length) {
-            float line_start = current_pos;
-            float line_end = std::min(current_pos + segment_length, length);
+    // true si habia un frame nuevo; pasa a ser el frente
+    bool acquire() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
 
-            sf::Vertex line[] = {
-                sf::Vertex(sf::Vector2f(x1 + dir_unit.x * line_start, y1 + dir_unit.y * line_start), color),
-                sf::Vertex(sf::Vector2f(x1 + dir_unit.x * line_end, y1 + dir_unit.y * line_end), color)
-            };
-            window.draw(line, 2, sf::Lines);
+    const DrawSnapshot& getFront() const { return frames[front]; }
+    unsigned int getFrontSeq() const { return seq[front]; }
 
-            current_pos += segment_length + gap_length;
-        }
+    // Solo lee capacidades: el hilo principal no cambia el tamaño de la copia que dibuja
+    void reportMemory(MemoryReport& report) const {
+        std::size_t bytes = 0;
+        for (int i = 0; i < 3; ++i) bytes += frames[i].getMemoryBytes();
+        report.add("Vertices y texturas", "Hilo de simulacion: copias de frame", bytes, 3);
     }
-    
-    int handleEvents(const sf::Event& event, sf::RenderWindow& window) override {
-        sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
+};
 
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-            int menu_status = checkMenuClick(mousePos);
-            if (menu_status == 0) return 0; 
-        }
+class SimulationThread {
+private:
+    Game& game;
+    FrameProfiler& profiler;
+    ResolutionScaler& scaler;
+    FrameTripleBuffer frames;
+    SpscQueue<InputEvent, 512> inputQueue;
+    std::atomic<bool> running;
+    std::atomic<int> profilerToggles;
+    std::atomic<int> traceDumps; // F4: el volcado se hace en este hilo, que es el que escribe los eventos
+    std::atomic<unsigned int> presentedSeq;
+    std::atomic<sf::Int64> presentedUs;
+    bool hasFrame; // Hilo principal: ya se recogio al menos un frame
+    sf::Thread thread;
+
+    void run() {
+        sf::Context context; // Texturas creadas al entrar a un nivel; se comparten con la ventana
+        std::vector<InputEvent> events;
+        events.reserve(64);
+        sf::Clock stepClock;
+        unsigned int published = 0;
+        unsigned int lastPresented = 0;
+
+        while (running.load(std::memory_order_acquire)) {
+            sf::Int64 sinceStep = stepClock.getElapsedTime().asMicroseconds();
+            if (sinceStep < SIM_MIN_STEP_US || (inputQueue.empty() && sinceStep < SIM_TICK_US)) {
+                sf::sleep(sf::milliseconds(1));
+                continue;
+            }
+            float dt = stepClock.restart().asSeconds();
 
-        inputWeightP2->handleEvent(event);
+            // Los cambios pendientes se dan por mostrados cuando se presenta el ultimo frame publicado
+            unsigned int presented = presentedSeq.load(std::memory_order_acquire);
+            if (presented != lastPresented && presented == published) {
+                LatencyTracker::instance().displayed(presentedUs.load(std::memory_order_relaxed));
+                lastPresented = presented;
+            }
 
-        if (event.type == sf::Event::MouseButtonPressed) {
-            if (event.mouseButton.button == sf::Mouse::Left) {
-                inputWeightP2->checkClick(mousePos);
+            profiler.beginFrame();
+            AllocStats allocsBefore = allocStatsNow();
+            for (int n = profilerToggles.exchange(0); n > 0; --n) profiler.toggle();
+#ifdef FISICA_TRACE
+            if (traceDumps.exchange(0) > 0) TraceRecorder::instance().writeJson("trace.json");
+#endif
+
+            {
+                ALLOC_SCOPE(AllocSubsystem::Events);
+                events.clear();
+                InputEvent e;
+                while (inputQueue.pop(e)) events.push_back(e);
+                game.handleInput(events);
+            }
+            profiler.mark(FramePhase::Events);
 
-                if (btnNewGame->isClicked(mousePos)) resetGame();
-                if (btnCalculate->isClicked(mousePos)) calculateEquilibrium();
-                
-                tooltip->hide();
-                
-                if (momentP1 > 0 || momentP2 > 0) {
-                    if (forceP1->checkHover(mousePos)) {
-                        tooltip->show(forceP1->getName(), forceP1->getFormula(), momentP1, mousePos, "Seesaw");
-                    } else if (forceP2->checkHover(mousePos)) {
-                        tooltip->show(forceP2->getName(), forceP2->getFormula(), momentP2, mousePos, "Seesaw");
-                    }
-                }
+            {
+                ALLOC_SCOPE(AllocSubsystem::Update);
+                game.update(dt);
             }
-        }
-        
-        if (momentP1 > 0 || momentP2 > 0) {
-            forceP1->checkHover(mousePos);
-            forceP2->checkHover(mousePos);
-        }
+            profiler.mark(FramePhase::Update);
+
+            RenderStats renderStats;
+            {
+                ALLOC_SCOPE(AllocSubsystem::Draw);
+                DrawSnapshot& snapshot = frames.beginBack();
+                CountingRenderTarget counted(snapshot, renderStats);
+                game.draw(counted, scaler);
+                RenderStats overlayStats; // Como en el bucle normal, el overlay no cuenta
+                CountingRenderTarget overlay(snapshot, overlayStats);
+                profiler.draw(overlay);
+            }
+            profiler.mark(FramePhase::Draw);
 
-        return 2; 
+            {
+                TRACE_SCOPE("publish");
+                frames.publish(++published);
+            }
+            profiler.mark(FramePhase::Display);
+            profiler.endFrame(game.getState(), renderStats, allocStatsNow().since(allocsBefore));
+        }
     }
 
-    void update(sf::RenderWindow& window) override {
-        // Nada
+public:
+    SimulationThread(Game& g, FrameProfiler& p, ResolutionScaler& s)
+        : game(g), profiler(p), scaler(s), running(false), profilerToggles(0), traceDumps(0), presentedSeq(0), presentedUs(0),
+          hasFrame(false), thread(&SimulationThread::run, this) {}
+
+    ~SimulationThread() { stop(); }
+
+    void start() {
+        running.store(true, std::memory_order_release);
+        thread.launch();
     }
 
-    void draw(sf::RenderWindow& window) override {
-        window.clear(sf::Color::White);
-        
-        inputWeightP2->draw(window);
-        btnCalculate->draw(window);
-        btnNewGame->draw(window);
-        btnMenu->draw(window);
-        
-        sf::Text labelInput;
-        labelInput.setFont(font); labelInput.setString("Peso P2 (kg):"); labelInput.setPosition(50.f, 50.f); labelInput.setCharacterSize(18); labelInput.setFillColor(sf::Color::Black);
-        window.draw(labelInput);
-        window.draw(msgLabel);
-        
-        drawData(window); // Dibujar datos primero para que no tapen los elementos centrales
+    void stop() {
+        running.store(false, std::memory_order_release);
+        thread.wait();
+    }
 
-        window.draw(base);
-        window.draw(board);
-        window.draw(pivot);
-        
-        window.draw(person1);
-        window.draw(person2);
-        
-        forceP1->draw(window);
-        forceP2->draw(window);
+    // Hilo principal
+    bool pushInput(const InputEvent& e) { return inputQueue.push(e); }
+    void toggleProfiler() { profilerToggles.fetch_add(1); }
+    void requestTraceDump() { traceDumps.fetch_add(1); }
+
+    // Dibuja el ultimo frame publicado; false si aun no hay ninguno
+    bool present(sf::RenderTarget& target) {
+        if (frames.acquire()) hasFrame = true;
+        if (!hasFrame) return false;
+        TRACE_SCOPE("SimulationThread::present");
+        frames.getFront().replay(target);
+        return true;
+    }
 
-        tooltip->draw(window);
+    // Llamar tras window.display() con el frame de present()
+    void presented(sf::Int64 displayedUs) {
+        presentedUs.store(displayedUs, std::memory_order_relaxed);
+        presentedSeq.store(frames.getFrontSeq(), std::memory_order_release);
     }
+
+    void reportMemory(MemoryReport& report) const { frames.reportMemory(report); }
 };
 
-// ----------------- Menú y Manejador Principal -----------------
-enum class GameState { Menu, Level1, Level2 };
+// Bucle del hilo principal con --sim-thread. Devuelve el numero de frames presentados.
+unsigned int runSimThread(sf::RenderWindow& window, SimulationThread& sim, InputStage& input) {
+    std::vector<InputEvent> backlog; // Lo que no cupo en la cola; se reintenta el frame siguiente
+    unsigned int frameIndex = 0;
+    sf::Event event;
 
-class GameMenu {
-// ... (Contenido de GameMenu)
-private:
-    sf::RectangleShape background;
-    Button* btnLevel1;
-    Button* btnLevel2;
-    sf::Font& font;
+    while (window.isOpen()) {
+        input.beginFrame();
+        while (window.pollEvent(event)) {
+            sf::Int64 polledUs = LatencyTracker::instance().now();
+            if (event.type == sf::Event::Closed) window.close();
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) sim.toggleProfiler();
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) sim.requestTraceDump();
+            input.add(event, window, polledUs);
+        }
+        for (const InputEvent& e : input.finish()) backlog.push_back(e);
+        std::size_t sent = 0;
+        while (sent < backlog.size() && sim.pushInput(backlog[sent])) ++sent;
+        backlog.erase(backlog.begin(), backlog.begin() + sent);
 
-public:
-    GameMenu(sf::Font& f) : font(f) {
-        background.setFillColor(sf::Color::White);
-        background.setSize(sf::Vector2f(1000, 700)); 
-        
-        float btn_w = 250.f;
-        float btn_h = 80.f;
-        float center_x = 500.f;
-        float center_y = 350.f;
+        window.clear(sf::Color::White);
+        bool shown = sim.present(window);
+        {
+            TRACE_SCOPE("display");
+            window.display();
+        }
+        if (!shown) continue;
+        sim.presented(LatencyTracker::instance().now());
 
-        btnLevel1 = new Button(center_x - btn_w - 20, center_y - btn_h/2, btn_w, btn_h, "NIVEL 1: Plano Inclinado", font, sf::Color(150, 150, 150));
-        btnLevel2 = new Button(center_x + 20, center_y - btn_h/2, btn_w, btn_h, "NIVEL 2: Sube y Baja", font, sf::Color(150, 150, 150));
+        if (StartupProfile::instance().isActive()) {
+            StartupProfile::instance().mark("Primer frame del hilo de simulacion");
+            StartupProfile::instance().finish();
+            StartupProfile::instance().print(std::cerr);
+        }
+        ++frameIndex;
     }
+    return frameIndex;
+}
+
 
-    ~GameMenu() {
-        delete btnLevel1;
-        delete btnLevel2;
+// bench.cpp incluye este archivo con FISICA_NO_MAIN para reutilizar las clases
+#ifndef FISICA_NO_MAIN
+int main(int argc, char** argv) {
+    StartupProfile::instance().begin();
+    ResolutionScaler scaler;
+    HeadlessOptions headless;
+    headless.seed = 1;
+    std::string recordPath, replayPath;
+    bool startupBench = false;
+    bool simThreadMode = false;
+    float startupBudgetMs = 0.f;
+    float evictLevelsAfter = 0.f;
+    bool saveEnabled = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--adaptive-res") scaler.setEnabled(true);
+        else if (arg == "--headless" && i + 1 < argc) headless.scriptPath = argv[++i];
+        else if (arg == "--dump-frames" && i + 1 < argc) headless.framesDir = argv[++i];
+        else if (arg == "--report" && i + 1 < argc) headless.reportPath = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) headless.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        else if (arg == "--replay-headless" && i + 1 < argc) headless.replayPath = argv[++i];
+        else if (arg == "--startup-bench") startupBench = true;
+        else if (arg == "--startup-budget" && i + 1 < argc) startupBudgetMs = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--sim-thread") simThreadMode = true;
+        else if (arg == "--evict-levels" && i + 1 < argc) evictLevelsAfter = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--no-save") saveEnabled = false;
+    }
+    if (!headless.scriptPath.empty() || !headless.replayPath.empty()) return runHeadless(headless);
+    // El hilo de simulacion consume la entrada en sus propios pasos, no en los frames presentados:
+    // una grabacion no se podria reproducir frame a frame
+    if (simThreadMode && (!replayPath.empty() || !recordPath.empty() || startupBench)) {
+        std::cerr << "Error: --sim-thread no se puede combinar con --record, --replay ni --startup-bench" << std::endl;
+        return -1;
     }
 
-    GameState handleEvent(const sf::Event& event, sf::Vector2f mousePos) {
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-            if (btnLevel1->isClicked(mousePos)) return GameState::Level1;
-            if (btnLevel2->isClicked(mousePos)) return GameState::Level2;
+    // Con --replay la entrada real se ignora (salvo cerrar y F3/F4) y se inyecta la grabada
+    InputReplay replay;
+    bool replaying = !replayPath.empty();
+    unsigned int seed = static_cast<unsigned int>(std::time(nullptr));
+    if (replaying) {
+        if (!replay.load(replayPath)) {
+            std::cerr << "Error: No se pudo leer la grabacion " << replayPath << std::endl;
+            return -1;
         }
-        return GameState::Menu;
+        seed = replay.getSeed();
     }
+    std::srand(seed);
 
-    void update(bool won1, bool won2) {
-        btnLevel1->setFillColor(won1 ? sf::Color::Green : sf::Color(150, 150, 150));
-        btnLevel2->setFillColor(won2 ? sf::Color::Green : sf::Color(150, 150, 150));
+    InputRecorder recorder;
+    if (!recordPath.empty() && !recorder.open(recordPath, seed)) {
+        std::cerr << "Error: No se pudo crear la grabacion " << recordPath << std::endl;
+        return -1;
     }
 
-    void draw(sf::RenderWindow& window) {
-        window.draw(background);
-        btnLevel1->draw(window);
-        btnLevel2->draw(window);
-        
-        sf::Text title;
-        title.setFont(font);
-        title.setString("Simulador de Estática");
-        title.setCharacterSize(40);
-        title.setFillColor(sf::Color::Black);
-        
-        sf::FloatRect bounds = title.getLocalBounds();
-        title.setOrigin(bounds.left + bounds.width/2.0f, bounds.top + bounds.height/2.0f);
-        title.setPosition(500.f, 150.f);
-        window.draw(title);
+    std::ofstream report;
+    if (replaying && !headless.reportPath.empty()) {
+        report.open(headless.reportPath);
+        report << "frame,state,events_us,update_us,draw_us,display_us,draw_calls,allocs\n";
     }
-};
+    std::vector<float> frameUs;
+    std::vector<InputEvent> injected;
+    InputStage input;
+    unsigned int frameIndex = 0;
+    StartupProfile::instance().mark("Argumentos");
 
-
-int main() {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
     sf::RenderWindow window(sf::VideoMode(1000, 700), "Simulacion Estatica");
     window.setFramerateLimit(60);
+    StartupProfile::instance().mark("Ventana y contexto OpenGL");
 
-    sf::Font font;
-    if (!font.loadFromFile("src/arial.ttf")) {
-        if (!font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf")) {
-            std::cerr << "Error: No se encontro arial.ttf" << std::endl;
-            return -1;
-        }
+    BakedFont font;
+    if (!font.loadEmbedded()) {
+        std::cerr << "Error: No se pudo crear la textura de la fuente" << std::endl;
+        return -1;
+    }
+    StartupProfile::instance().mark("Fuente");
+
+    // Las grabaciones no guardan el catalogo: se graban y reproducen (tambien headless) con
+    // el de por defecto y sin recarga en caliente
+    bool fixedCatalogue = replaying || !recordPath.empty();
+    LevelCatalogue catalogue = fixedCatalogue ? LevelCatalogue() : loadLevelCatalogue(LEVEL_CATALOGUE_PATH);
+    StartupProfile::instance().mark("Catalogo de niveles");
+
+    Game game(font, catalogue); // Solo construye el menu; los niveles se crean al entrar
+    game.setLevelEviction(evictLevelsAfter);
+    if (!fixedCatalogue) game.watchCatalogue(LEVEL_CATALOGUE_PATH);
+
+    // Una grabacion debe empezar y reproducirse desde el mismo estado: sin partida guardada
+    if (saveEnabled && !replaying && recordPath.empty() && !startupBench) {
+        game.enableSave(SAVE_PATH);
+        StartupProfile::instance().mark("Partida guardada");
     }
 
-    Simulator level1(font);
-    SeesawSimulator level2(font);
-    GameMenu menu(font);
-
-    GameState currentState = GameState::Menu;
-    bool level1Won = false;
-    bool level2Won = false;
+    FrameProfiler profiler(font);
+    StartupProfile::instance().mark("FrameProfiler");
+
+    SimulationThread* simThread = nullptr;
+    auto collectMemory = [&](MemoryReport& report) {
+        font.reportMemory(report);
+        game.reportMemory(report);
+        TextRunCache::shared().reportMemory(report);
+        scaler.reportMemory(report);
+        profiler.reportMemory(report);
+        if (simThread) simThread->reportMemory(report);
+    };
+    profiler.setMemorySource(collectMemory);
+
+    // Unica consulta de sf::Mouse: posicion inicial hasta el primer evento de raton
+    input.setMousePos(window.mapPixelToCoords(sf::Mouse::getPosition(window)));
+
+    // Con --sim-thread el bucle de abajo no llega a ejecutarse: runSimThread vuelve con la ventana cerrada
+    if (simThreadMode) {
+        if (scaler.isEnabled()) std::cerr << "Aviso: --adaptive-res no se aplica con --sim-thread" << std::endl;
+        SimulationThread sim(game, profiler, scaler);
+        sim.start();
+        simThread = &sim;
+        frameIndex = runSimThread(window, sim, input);
+        sim.stop();
+        simThread = nullptr;
+    }
 
+    sf::Clock frameClock;
     while (window.isOpen()) {
+        float dt = frameClock.restart().asSeconds();
+        profiler.beginFrame();
+        AllocStats allocsBefore = allocStatsNow();
         sf::Event event;
-        sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
 
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) window.close();
+        {
+            ALLOC_SCOPE(AllocSubsystem::Events);
+            input.beginFrame();
+            while (window.pollEvent(event)) {
+                sf::Int64 polledUs = LatencyTracker::instance().now();
+                if (event.type == sf::Event::Closed) window.close();
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) profiler.toggle();
+#ifdef FISICA_TRACE
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) TraceRecorder::instance().writeJson("trace.json");
+#endif
+                if (!replaying) input.add(event, window, polledUs);
+            }
 
-            if (currentState == GameState::Menu) {
-                GameState nextState = menu.handleEvent(event, mousePos);
-                if (nextState != GameState::Menu) currentState = nextState;
-            } else if (currentState == GameState::Level1) {
-                int status = level1.handleEvents(event, window);
-                if (status == 0) {
-                    if (level1.getIsWon()) level1Won = true;
-                    currentState = GameState::Menu;
-                }
-            } else if (currentState == GameState::Level2) {
-                int status = level2.handleEvents(event, window);
-                if (status == 0) {
-                    if (level2.getIsWon()) level2Won = true;
-                    currentState = GameState::Menu;
-                }
+            if (replaying) {
+                injected.clear();
+                replay.eventsForFrame(frameIndex, injected);
+                sf::Int64 now = LatencyTracker::instance().now();
+                for (InputEvent& e : injected) e.polledUs = now;
+                game.handleInput(injected);
+            } else {
+                const std::vector<InputEvent>& frameEvents = input.finish();
+                for (const InputEvent& e : frameEvents) recorder.record(frameIndex, e.event, e.mousePos);
+                game.handleInput(frameEvents);
             }
         }
+        profiler.mark(FramePhase::Events);
 
-        if (currentState == GameState::Menu) {
-            menu.update(level1Won, level2Won);
-            menu.draw(window);
-        } else if (currentState == GameState::Level1) {
-            level1.draw(window);
-        } else if (currentState == GameState::Level2) {
-            level2.draw(window);
+        {
+            ALLOC_SCOPE(AllocSubsystem::Update);
+            game.update(dt);
         }
+        profiler.mark(FramePhase::Update);
+
+        RenderStats renderStats;
+        {
+            ALLOC_SCOPE(AllocSubsystem::Draw);
+            CountingRenderTarget counted(window, renderStats);
+            game.draw(counted, scaler);
+            profiler.draw(window);
+        }
+        profiler.mark(FramePhase::Draw);
+        StartupProfile::instance().mark("Primer frame (eventos y draw)");
 
-        window.display();
+        scaler.adapt(profiler.getWorkTime());
+        {
+            TRACE_SCOPE("display");
+            window.display();
+        }
+        LatencyTracker::instance().displayed();
+
+        if (StartupProfile::instance().isActive()) {
+            StartupProfile::instance().mark("Primer display");
+            StartupProfile::instance().finish();
+            StartupProfile::instance().print(std::cerr);
+            if (startupBench) {
+                float ttffMs = StartupProfile::instance().getTimeToFirstFrame() / 1000.f;
+                if (startupBudgetMs > 0.f && ttffMs > startupBudgetMs) {
+                    std::cerr << "Presupuesto de arranque excedido: " << ttffMs << " ms > " << startupBudgetMs << " ms" << std::endl;
+                    return 2;
+                }
+                return 0;
+            }
+        }
+        profiler.mark(FramePhase::Display);
+        AllocStats frameAllocs = allocStatsNow().since(allocsBefore);
+        profiler.endFrame(game.getState(), renderStats, frameAllocs);
+
+        if (replaying) {
+            frameUs.push_back(profiler.getWorkTime() * 1e6f);
+            if (report.is_open()) {
+                report << frameIndex << "," << stateName(game.getState()) << ","
+                       << static_cast<int>(profiler.getPhaseTime(FramePhase::Events) * 1e6f) << ","
+                       << static_cast<int>(profiler.getPhaseTime(FramePhase::Update) * 1e6f) << ","
+                       << static_cast<int>(profiler.getPhaseTime(FramePhase::Draw) * 1e6f) << ","
+                       << static_cast<int>(profiler.getPhaseTime(FramePhase::Display) * 1e6f) << ","
+                       << renderStats.drawCalls << "," << frameAllocs.totalCount() << "\n";
+            }
+        }
+        ++frameIndex;
+        if (replaying && replay.finished(frameIndex)) window.close();
     }
 
+    recorder.close(frameIndex);
+    if (replaying) printReplaySummary(frameUs);
+    LatencyTracker::instance().printSummary(std::cerr);
+
+    MemoryReport memory;
+    collectMemory(memory);
+    memory.print(std::cerr);
+
+#ifdef FISICA_TRACE
+    TraceRecorder::instance().writeJson("trace.json");
+#endif
+
     return 0;
 
 }
+#endif